@@ -0,0 +1,58 @@
+// Frame memory per suspended actor and cost per resume of coroutine
+// behaviors.
+//
+// usage: driver [actors] [ticks]
+
+#include <libcosy/behavior.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+
+namespace {
+
+  class U64Type: public AttributeType {
+  public:
+
+    U64Type(): AttributeType("u64") {}
+
+    auto size()      -> int override { return 8; }
+    auto alignment() -> int override { return 8; }
+  };
+
+  // Passes a token to its successor on a ring every other tick.
+  auto node_(Actor self, ActorId next) ->Behavior {
+    for (;;) {
+      auto msg = co_await self.receive();
+      co_await self.sleep(1);
+      self.send(next, msg.payload);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  ActorId num_actors = argc > 1? std::strtoull(argv[1], nullptr, 10) : 1 << 20;
+  int     ticks      = argc > 2? std::atoi(argv[2]) : 20;
+
+  U64Type u64;
+  ActorType type("node", RecordType{Attribute{.name = "state", .type = &u64}});
+  Scheduler scheduler;
+  for (ActorId id = 1; id <= num_actors; ++id)
+    scheduler.spawn(node_(scheduler.actor(type, id), id % num_actors + 1));
+  scheduler.tick();
+  for (ActorId id = 1; id <= num_actors; id += 2) scheduler.send(0, id, std::span("tok", 3));
+
+  size_t resumed = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int tick = 0; tick < ticks; ++tick) resumed += scheduler.tick();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  auto& pool = scheduler.pool(type);
+  std::cout << std::format(
+    "{} actors: {} frame bytes per actor, {:.1f} ns per resume\n",
+    num_actors,
+    pool.reservedSize() / pool.numAllocated(),
+    elapsed.count() * 1e9 / resumed
+  );
+}
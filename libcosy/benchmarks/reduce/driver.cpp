@@ -0,0 +1,79 @@
+// Per tick statistics over an attribute: full parallel rescans against
+// incremental aggregates fed by tracked writes.
+//
+// usage: driver [actors] [writes per tick] [ticks]
+
+#include <libcosy/reduce.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <random>
+
+namespace {
+
+  class F64Type: public AttributeType {
+  public:
+
+    F64Type(): AttributeType("f64") {}
+
+    auto size()      -> int override { return 8; }
+    auto alignment() -> int override { return 8; }
+  };
+
+  template<class Fn>
+  auto time_(Fn fn) ->double {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+  }
+}
+
+int main(int argc, char** argv) {
+  ActorId num_actors = argc > 1? std::strtoull(argv[1], nullptr, 10) : 1 << 22;
+  size_t  writes     = argc > 2? std::strtoull(argv[2], nullptr, 10) : 1000;
+  int     ticks      = argc > 3? std::atoi(argv[3]) : 20;
+
+  F64Type f64;
+  ActorType type("actor", RecordType{
+    Attribute{.name = "position", .type = &f64},
+    Attribute{.name = "velocity", .type = &f64},
+    Attribute{.name = "energy",   .type = &f64},
+  });
+  auto& energy = *type.attribute("energy");
+  Table table(&type);
+  table.newActors(num_actors);
+
+  std::mt19937_64 rng(1);
+  std::uniform_real_distribution<double> dist(0, 1);
+  for (uint64_t slot = 0; slot < num_actors; ++slot) table.field(energy).set(slot, dist(rng));
+  std::uniform_int_distribution<ActorId> pick(1, num_actors);
+
+  double sink = 0;
+  auto single = time_([&] {
+    for (int tick = 0; tick < ticks; ++tick) {
+      for (size_t w = 0; w < writes; ++w) table.field(energy).set(table.slot(pick(rng)), dist(rng));
+      sink += stats<double>(table, energy, 1).sum;
+    }
+  });
+  auto parallel = time_([&] {
+    for (int tick = 0; tick < ticks; ++tick) {
+      for (size_t w = 0; w < writes; ++w) table.field(energy).set(table.slot(pick(rng)), dist(rng));
+      sink += stats<double>(table, energy).sum;
+    }
+  });
+  IncrementalStats<double> inc(table, energy, Histogram<double>(0, 1, 16));
+  auto incremental = time_([&] {
+    for (int tick = 0; tick < ticks; ++tick) {
+      for (size_t w = 0; w < writes; ++w) inc.set(pick(rng), dist(rng));
+      sink += inc.stats().sum;
+    }
+  });
+
+  std::cout << std::format("{} actors, {} writes per tick (checksum {:.3f})\n", num_actors, writes, sink);
+  std::cout << std::format("rescan, 1 thread   {:>10.3f} ms per tick\n", single * 1e3 / ticks);
+  std::cout << std::format("rescan, parallel   {:>10.3f} ms per tick\n", parallel * 1e3 / ticks);
+  std::cout << std::format("incremental        {:>10.3f} ms per tick\n", incremental * 1e3 / ticks);
+}
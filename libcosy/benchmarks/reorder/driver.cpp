@@ -0,0 +1,119 @@
+// Neighbour access on a 2D grid of actors spawned in random order, before
+// and after reordering the table along space-filling curves and in
+// Cuthill-McKee order.
+//
+// usage: driver [grid side] [sweeps]
+
+#include <libcosy/reorder.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <numeric>
+#include <random>
+
+namespace {
+
+  class PayloadType: public AttributeType {
+  public:
+
+    PayloadType(): AttributeType("payload") {}
+
+    auto size()      -> int override { return 64; }
+    auto alignment() -> int override { return 8; }
+  };
+
+  struct Grid_ {
+    uint32_t             side;
+    std::vector<ActorId> cell_ids; // actor id of each cell
+    std::vector<uint64_t> cells;   // cell of each actor id - 1
+
+    auto neighbours(ActorId id, std::vector<ActorId>& out) const {
+      auto cell = cells[id - 1];
+      auto x = cell % side, y = cell / side;
+      if (x > 0)        out.push_back(cell_ids[cell - 1]);
+      if (x + 1 < side) out.push_back(cell_ids[cell + 1]);
+      if (y > 0)        out.push_back(cell_ids[cell - side]);
+      if (y + 1 < side) out.push_back(cell_ids[cell + side]);
+    }
+  };
+
+  uint64_t checksum_ = 0;
+
+  // Sums a field over the four neighbours of every actor, in slot order.
+  auto sweep_(Table& table, const Attribute& attr, const Grid_& grid, int sweeps) ->double {
+    auto n = table.numActors();
+    std::vector<uint64_t> adjacent;
+    std::vector<uint32_t> offsets{0};
+    std::vector<ActorId>  ids;
+    for (uint64_t slot = 0; slot < n; ++slot) {
+      ids.clear();
+      grid.neighbours(table.actorAt(slot), ids);
+      for (auto id: ids) adjacent.push_back(table.slot(id));
+      offsets.push_back(adjacent.size());
+    }
+
+    auto field = table.field(attr);
+    uint64_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < sweeps; ++s) {
+      for (uint64_t slot = 0; slot < n; ++slot) {
+        for (auto i = offsets[slot]; i < offsets[slot + 1]; ++i) sum += field.get<uint64_t>(adjacent[i]);
+      }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    checksum_ += sum;
+    return elapsed.count() / sweeps;
+  }
+}
+
+int main(int argc, char** argv) {
+  uint32_t side   = argc > 1? std::atoi(argv[1]) : 2048;
+  int      sweeps = argc > 2? std::atoi(argv[2]) : 5;
+
+  Grid_ grid{.side = side, .cell_ids = {}, .cells = {}};
+  grid.cell_ids.resize(uint64_t(side) * side);
+  std::iota(grid.cell_ids.begin(), grid.cell_ids.end(), 1);
+  std::shuffle(grid.cell_ids.begin(), grid.cell_ids.end(), std::mt19937_64(1));
+  grid.cells.resize(grid.cell_ids.size());
+  for (uint64_t cell = 0; cell < grid.cell_ids.size(); ++cell) grid.cells[grid.cell_ids[cell] - 1] = cell;
+
+  PayloadType payload;
+  ActorType type("cell", RecordType{Attribute{.name = "payload", .type = &payload}});
+  auto& attr = *type.attribute("payload");
+  Table table(&type);
+  table.newActors(grid.cell_ids.size());
+
+  auto cellKey = [&grid](auto curve) {
+    return [&grid, curve](ActorId id) {
+      auto cell = grid.cells[id - 1];
+      return curve(uint32_t(cell % grid.side), uint32_t(cell / grid.side));
+    };
+  };
+  auto morton  = [](uint32_t x, uint32_t y) { return mortonKey(x, y); };
+  auto hilbert = [](uint32_t x, uint32_t y) { return hilbertKey(x, y); };
+
+  std::cout << std::format("{}x{} grid\n", side, side);
+  auto base = sweep_(table, attr, grid, sweeps);
+  auto report = [base](const char* name, double elapsed) {
+    std::cout << std::format("{:<12} {:>9.2f} ms per sweep, speedup {:>5.2f}\n", name, elapsed * 1e3, base / elapsed);
+  };
+  report("random", base);
+
+  auto start = std::chrono::steady_clock::now();
+  table.reorder(keyOrder(table, cellKey(morton)));
+  std::chrono::duration<double> reorder = std::chrono::steady_clock::now() - start;
+  report("morton", sweep_(table, attr, grid, sweeps));
+  std::cout << std::format("  reorder pass {:.2f} ms\n", reorder.count() * 1e3);
+
+  table.reorder(keyOrder(table, cellKey(hilbert)));
+  report("hilbert", sweep_(table, attr, grid, sweeps));
+
+  table.reorder(cuthillMcKeeOrder(table, [&grid](ActorId id, std::vector<ActorId>& out) {
+    grid.neighbours(id, out);
+  }));
+  report("rcm", sweep_(table, attr, grid, sweeps));
+  std::cout << std::format("(checksum {})\n", checksum_);
+}
@@ -0,0 +1,90 @@
+// Chained set algebra on fragmented actor sets, evaluated eagerly one
+// operation at a time and as a single fused set expression, and building
+// sets from unsorted ids one at a time and in bulk.
+//
+// usage: driver [segments per set] [repetitions] [unsorted ids]
+
+#include <libcosy/integral_set.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+  using ActorSet = IntegralSet<uint64_t>;
+
+  // A set of random segments and gaps of up to 16 ids each.
+  auto randomSet_(size_t segments, std::mt19937_64& rng) ->ActorSet {
+    std::uniform_int_distribution<uint64_t> len(1, 16);
+    ActorSet set;
+    uint64_t pos = 1;
+    for (size_t i = 0; i < segments; ++i) {
+      pos += len(rng);
+      auto last = pos + len(rng) - 1;
+      set.merge(ActorSet{{pos, last}});
+      pos = last + 1;
+    }
+    return set;
+  }
+
+  template<class Fn>
+  auto time_(int reps, Fn fn) ->double {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r) fn();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / reps;
+  }
+}
+
+int main(int argc, char** argv) {
+  size_t segments = argc > 1? std::atoi(argv[1]) : 200000;
+  int    reps     = argc > 2? std::atoi(argv[2]) : 20;
+  size_t num_ids  = argc > 3? std::atoi(argv[3]) : 4000000;
+
+  std::mt19937_64 rng(1);
+  auto a = randomSet_(segments, rng), b = randomSet_(segments, rng);
+  auto c = randomSet_(segments, rng), d = randomSet_(segments, rng);
+
+  size_t checksum = 0;
+  auto eager = time_(reps, [&]() {
+    checksum += a.intersect(b).unite(c).difference(d).size();
+  });
+  auto fused = time_(reps, [&]() {
+    checksum += ActorSet(((a & b) | c) - d).size();
+  });
+  auto count = time_(reps, [&]() {
+    checksum += (((a & b) | c) - d).size();
+  });
+
+  std::cout << std::format("{} segments per set, result {} ids\n", segments, (((a & b) | c) - d).size());
+  std::cout << std::format("{:<8} {:>9.3f} ms\n", "eager", eager * 1e3);
+  std::cout << std::format("{:<8} {:>9.3f} ms, speedup {:>5.2f}\n", "fused", fused * 1e3, eager / fused);
+  std::cout << std::format("{:<8} {:>9.3f} ms, speedup {:>5.2f}\n", "size", count * 1e3, eager / count);
+
+  // Query results: every other id of a dense range, shuffled.
+  std::vector<uint64_t> ids(num_ids);
+  std::iota(ids.begin(), ids.end(), 0);
+  for (auto& id: ids) id = 2 * id + 1;
+  std::shuffle(ids.begin(), ids.end(), rng);
+  auto few = std::min<size_t>(num_ids, 100000);
+  auto single = time_(1, [&]() {
+    ActorSet set;
+    for (size_t i = 0; i < few; ++i) set.insert(ids[i]);
+    checksum += set.size();
+  });
+  auto bulk1 = time_(reps, [&]() { checksum += ActorSet(ids, 1).size(); });
+  auto bulk  = time_(reps, [&]() { checksum += ActorSet(ids).size(); });
+
+  std::cout << std::format("\n{} unsorted ids\n", num_ids);
+  std::cout << std::format("{:<8} {:>9.3f} ms for {} ids\n", "insert", single * 1e3, few);
+  std::cout << std::format("{:<8} {:>9.3f} ms, 1 thread\n", "bulk", bulk1 * 1e3);
+  std::cout << std::format("{:<8} {:>9.3f} ms, {} threads\n", "bulk", bulk * 1e3, std::thread::hardware_concurrency());
+  std::cout << std::format("(checksum {})\n", checksum);
+}
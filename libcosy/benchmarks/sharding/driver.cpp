@@ -0,0 +1,88 @@
+// Strong scaling of a sharded ring simulation over 1 to N processes
+// connected by Unix domain sockets.
+//
+// usage: driver [actors] [max processes] [ticks]
+
+#include <libcosy/shard.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <thread>
+
+#include <unistd.h>
+
+namespace {
+
+  class U64Type: public AttributeType {
+  public:
+
+    U64Type(): AttributeType("u64") {}
+
+    auto size()      -> int override { return 8; }
+    auto alignment() -> int override { return 8; }
+  };
+
+  // Each actor averages its state with its ring successor, which for the
+  // last actor of a shard is a ghost.
+  auto run_(Transport& transport, ActorId num_actors, int ticks) ->double {
+    U64Type u64;
+    ActorType type("node", RecordType{
+      Attribute{.name = "state", .type = &u64, .double_buffered = true},
+    });
+    auto& state = *type.attribute("state");
+    Shard shard(&type, ShardMap::partition(ActorSet{{1, num_actors}}, transport.size()), transport);
+    auto& table = shard.table();
+    auto  own   = shard.map().shard(shard.rank());
+    auto  last  = own.segments().back().second;
+    auto  ghost = last % num_actors + 1;
+    shard.setGhosts(own.contains(ghost)? ActorSet{} : ActorSet{ghost});
+
+    for (uint64_t slot = 0; slot < table.numActors(); ++slot)
+      table.next(state).set<uint64_t>(slot, table.actorAt(slot));
+    table.swapBuffers();
+    shard.exchange();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < ticks; ++tick) {
+      auto cur  = table.current(state);
+      auto next = table.next(state);
+      auto n    = table.numActors();
+      for (uint64_t slot = 0; slot + 1 < n; ++slot)
+        next.set<uint64_t>(slot, (cur.get<uint64_t>(slot) + cur.get<uint64_t>(slot + 1)) / 2);
+      auto succ = own.contains(ghost)
+        ? cur.get<uint64_t>(table.slot(ghost))
+        : shard.ghosts().current(state).get<uint64_t>(0);
+      next.set<uint64_t>(table.slot(last), (cur.get<uint64_t>(table.slot(last)) + succ) / 2);
+      table.swapBuffers();
+      shard.exchange();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+  }
+}
+
+int main(int argc, char** argv) {
+  ActorId num_actors = argc > 1? std::strtoull(argv[1], nullptr, 10) : 1 << 22;
+  int     max_procs  = argc > 2? std::atoi(argv[2]) : std::thread::hardware_concurrency();
+  int     ticks      = argc > 3? std::atoi(argv[3]) : 50;
+
+  double base = 0;
+  std::cout << std::format("{} actors, {} ticks\n", num_actors, ticks);
+  for (int procs = 1; procs <= std::max(max_procs, 1); ++procs) {
+    double elapsed;
+    {
+      auto transport = UnixSocketTransport::fork(procs);
+      elapsed = run_(*transport, num_actors, ticks);
+      if (transport->rank() != 0) _exit(0);
+    }
+    if (procs == 1) base = elapsed;
+    std::cout << std::format(
+      "{:>3} processes {:>10.1f} Mupdates/s efficiency {:>5.2f}\n",
+      procs,
+      double(num_actors) * ticks / elapsed / 1e6,
+      base / (procs * elapsed)
+    );
+  }
+}
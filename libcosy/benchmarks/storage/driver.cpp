@@ -0,0 +1,112 @@
+// Iteration throughput over a Table with different storage allocators.
+//
+// usage: driver [actors] [threads]
+
+#include <libcosy/table.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <format>
+#include <thread>
+#include <vector>
+
+namespace {
+
+  class BytesType: public AttributeType {
+  public:
+
+    BytesType(int size): AttributeType("bytes"), size_(size) {}
+
+    auto size()      -> int override { return size_; }
+    auto alignment() -> int override { return 8; }
+
+  private:
+
+    int size_;
+  };
+
+  struct Config {
+    std::string                       name;
+    std::shared_ptr<StorageAllocator> allocator;
+    bool                              place_chunks;
+  };
+
+  void run_(const Config& config, uint64_t num_actors, unsigned num_threads) {
+    BytesType bytes(64);
+    ActorType type("actor", RecordType{Attribute{.name = "payload", .type = &bytes}});
+    Table table(
+      &type,
+      std::make_shared<ActorSet>(ActorSet{{1, num_actors}}),
+      config.allocator
+    );
+    table.newActors(num_actors);
+
+    auto chunk = (num_actors + num_threads - 1) / num_threads;
+    auto for_chunks = [&](const std::function<void(uint64_t, uint64_t)>& fn) {
+      std::vector<std::jthread> threads;
+      for (unsigned t = 0; t < num_threads; ++t) {
+        auto first = t * chunk;
+        auto last  = std::min(first + chunk, num_actors);
+        threads.emplace_back([&fn, first, last] { if (first < last) fn(first, last); });
+      }
+    };
+
+    // Every worker places and writes its own chunk. Spawning leaves mmap
+    // memory untouched, so these writes are the first touch; heap records
+    // were already zeroed by the spawning thread.
+    for_chunks([&](uint64_t first, uint64_t last) {
+      if (config.place_chunks) table.placeSlots(first, last - first, currentNumaNode());
+      for (auto slot = first; slot < last; ++slot) {
+        uint64_t val = slot;
+        std::memcpy(table.data() + slot * type.size(), &val, sizeof(val));
+      }
+    });
+
+    constexpr int passes = 10;
+    std::vector<uint64_t> sums(num_threads);
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+      for_chunks([&](uint64_t first, uint64_t last) {
+        uint64_t sum = 0;
+        for (auto slot = first; slot < last; ++slot) {
+          uint64_t val;
+          std::memcpy(&val, table.data() + slot * type.size(), sizeof(val));
+          sum += val;
+        }
+        sums[first / chunk] += sum;
+      });
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    auto records = double(num_actors) * passes;
+    std::cout << std::format(
+      "{:<28} {:>10.1f} Mrecords/s {:>8.2f} GB/s\n",
+      config.name,
+      records / elapsed.count() / 1e6,
+      records * type.size() / elapsed.count() / 1e9
+    );
+  }
+}
+
+int main(int argc, char** argv) {
+  uint64_t num_actors  = argc > 1? std::strtoull(argv[1], nullptr, 10) : 1 << 22;
+  unsigned num_threads = argc > 2? std::atoi(argv[2]) : std::thread::hardware_concurrency();
+  if (num_threads == 0) num_threads = 1;
+
+  std::vector<Config> configs{
+    {"heap",                  std::make_shared<HeapAllocator>(),                                          false},
+    {"mmap",                  std::make_shared<MmapAllocator>(HugePages::none),                           false},
+    {"mmap thp",              std::make_shared<MmapAllocator>(HugePages::transparent),                    false},
+    {"mmap hugetlb",          std::make_shared<MmapAllocator>(HugePages::reserved),                       false},
+    {"mmap thp interleave",   std::make_shared<MmapAllocator>(HugePages::transparent, NumaPolicy::interleave), false},
+    {"mmap thp worker-local", std::make_shared<MmapAllocator>(HugePages::transparent),                    true},
+  };
+
+  std::cout << std::format(
+    "{} actors, {} threads, {} NUMA nodes\n", num_actors, num_threads, numNumaNodes());
+  for (const auto& config: configs) run_(config, num_actors, num_threads);
+}
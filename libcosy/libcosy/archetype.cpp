@@ -0,0 +1,194 @@
+#include <libcosy/archetype.hpp>
+
+#include <cstring>
+#include <limits>
+
+namespace {
+  auto typeName_(const Archetype::Key& key) ->std::string {
+    std::string name = "{";
+    for (const auto& attr: key) {
+      if (name.size() > 1) name += ", ";
+      name += attr;
+    }
+    return name + "}";
+  }
+}
+
+Archetype::Archetype(const Key& key, ActorType&& type, std::shared_ptr<ActorSet> id_pool):
+  key_(key),
+  type_(std::make_unique<ActorType>(std::move(type))),
+  table_(type_.get(), std::move(id_pool)) {}
+
+auto Archetype::key() const ->const Key& {
+  return key_;
+}
+
+auto Archetype::type() ->ActorType& {
+  return *type_;
+}
+
+auto Archetype::table() ->Table& {
+  return table_;
+}
+
+ArchetypeStore::ArchetypeStore():
+  id_pool_(std::make_shared<ActorSet>(
+    ActorSet{std::make_pair(1, std::numeric_limits<ActorId>::max())})) {}
+
+auto ArchetypeStore::archetype(const std::vector<Attribute>& attributes) ->Archetype& {
+  Archetype::Key key;
+  for (const auto& attr: attributes) {
+    registerAttribute_(attr);
+    key.push_back(attr.name);
+  }
+  ranges::sort(key);
+  if (ranges::adjacent_find(key) != key.end())
+    throw std::invalid_argument("multiple attributes with the same name");
+  return archetype_(std::move(key));
+}
+
+auto ArchetypeStore::spawn(Archetype& archetype, int n) ->ActorSet {
+  return archetype.table().newActors(n);
+}
+
+void ArchetypeStore::despawn(Archetype& archetype, const ActorSet& ids) {
+  archetype.table().deleteActors(ids);
+}
+
+auto ArchetypeStore::addAttribute(
+  Archetype&       from,
+  const ActorSet&  ids,
+  const Attribute& attribute
+) ->Archetype& {
+  registerAttribute_(attribute);
+  auto it = from.add_edges_.find(attribute.name);
+  if (it == from.add_edges_.end()) {
+    if (ranges::binary_search(from.key_, attribute.name))
+      throw std::invalid_argument(std::format("archetype already has attribute '{}'", attribute.name));
+    auto key = from.key_;
+    key.insert(ranges::upper_bound(key, attribute.name), attribute.name);
+    it = from.add_edges_.emplace(attribute.name, edge_(from, std::move(key))).first;
+  }
+  move_(from, it->second, ids);
+  return *it->second.target;
+}
+
+auto ArchetypeStore::removeAttribute(
+  Archetype&         from,
+  const ActorSet&    ids,
+  const std::string& name
+) ->Archetype& {
+  auto it = from.remove_edges_.find(name);
+  if (it == from.remove_edges_.end()) {
+    auto key = from.key_;
+    auto kit = ranges::lower_bound(key, name);
+    if (kit == key.end() || *kit != name)
+      throw std::invalid_argument(std::format("archetype has no attribute '{}'", name));
+    key.erase(kit);
+    it = from.remove_edges_.emplace(name, edge_(from, std::move(key))).first;
+  }
+  move_(from, it->second, ids);
+  return *it->second.target;
+}
+
+auto ArchetypeStore::numArchetypes() const ->size_t {
+  return archetypes_.size();
+}
+
+void ArchetypeStore::registerAttribute_(const Attribute& attribute) {
+  if (attribute.name.size() == 0)
+    throw std::invalid_argument("attribute must be named");
+  auto [it, inserted] = attributes_.emplace(attribute.name, attribute);
+  if (!inserted && it->second.type != attribute.type)
+    throw std::invalid_argument(std::format("attribute '{}' redefined with another type", attribute.name));
+  if (!inserted && (
+    it->second.double_buffered != attribute.double_buffered ||
+    it->second.cold != attribute.cold ||
+    it->second.column != attribute.column
+  )) throw std::invalid_argument(std::format("attribute '{}' redefined with another storage", attribute.name));
+}
+
+auto ArchetypeStore::archetype_(Archetype::Key key) ->Archetype& {
+  auto it = archetypes_.find(key);
+  if (it != archetypes_.end()) return *it->second;
+  std::vector<Attribute> attributes;
+  for (const auto& name: key) attributes.push_back(attributes_.at(name));
+  auto name = typeName_(key);
+  auto archetype = std::make_unique<Archetype>(
+    key,
+    ActorType(name, RecordType(std::move(attributes))),
+    id_pool_
+  );
+  return *archetypes_.emplace(std::move(key), std::move(archetype)).first->second;
+}
+
+// Fields adjacent in both records are coalesced so that a move does as few
+// copies per actor as possible.
+auto ArchetypeStore::edge_(Archetype& from, Archetype::Key key) ->Archetype::Edge_ {
+  auto& target = archetype_(std::move(key));
+  Archetype::Edge_ edge{.target = &target, .copies = {}, .buffered_copies = {}, .cold_copies = {}, .column_copies = {}};
+  for (const auto& dst: target.type().attributes()) {
+    auto src = from.type().attribute(dst.name);
+    if (src == nullptr) continue;
+    if (dst.cold) {
+      edge.cold_copies.emplace_back(src, &dst);
+      continue;
+    }
+    if (dst.column) {
+      edge.column_copies.emplace_back(src, &dst);
+      continue;
+    }
+    auto& copies = dst.double_buffered? edge.buffered_copies : edge.copies;
+    copies.push_back({.src_offset = src->offset, .dst_offset = dst.offset, .size = dst.type->size()});
+  }
+  for (auto copies: {&edge.copies, &edge.buffered_copies}) {
+    ranges::sort(*copies, {}, &Archetype::FieldCopy_::src_offset);
+    std::vector<Archetype::FieldCopy_> coalesced;
+    for (const auto& copy: *copies) {
+      if (!coalesced.empty()) {
+        auto& last = coalesced.back();
+        if (last.src_offset + last.size == copy.src_offset &&
+            last.dst_offset + last.size == copy.dst_offset) {
+          last.size += copy.size;
+          continue;
+        }
+      }
+      coalesced.push_back(copy);
+    }
+    *copies = std::move(coalesced);
+  }
+  return edge;
+}
+
+void ArchetypeStore::move_(Archetype& from, const Archetype::Edge_& edge, const ActorSet& ids) {
+  auto& src = from.table();
+  auto& dst = edge.target->table();
+  ids.forEach([&](ActorId id) {
+    if (!src.contains(id))
+      throw std::invalid_argument(std::format("actor {} is not in the archetype", id));
+  });
+  dst.insertActors(ids);
+  std::vector<char> val;
+  ids.forEach([&](ActorId id) {
+    for (const auto& [src_attr, dst_attr]: edge.cold_copies) {
+      val.resize(src_attr->type->size());
+      src.cold(*src_attr).get(src.slot(id), val.data());
+      dst.cold(*dst_attr).set(dst.slot(id), val.data());
+    }
+    for (const auto& [src_attr, dst_attr]: edge.column_copies) {
+      val.resize(src_attr->type->size());
+      src.getColumnValue(*src_attr, src.slot(id), val.data());
+      dst.setColumnValue(*dst_attr, dst.slot(id), val.data());
+    }
+    auto src_rec = src.record(id);
+    auto dst_rec = dst.record(id);
+    for (const auto& copy: edge.copies)
+      std::memcpy(dst_rec + copy.dst_offset, src_rec + copy.src_offset, copy.size);
+    if (edge.buffered_copies.empty()) return;
+    auto src_buf = src.bufferedRecord(id);
+    auto dst_buf = dst.bufferedRecord(id);
+    for (const auto& copy: edge.buffered_copies)
+      std::memcpy(dst_buf + copy.dst_offset, src_buf + copy.src_offset, copy.size);
+  });
+  src.extractActors(ids);
+}
@@ -0,0 +1,90 @@
+#ifndef archetype_hpp_INCLUDED
+#define archetype_hpp_INCLUDED
+
+#include <libcosy/table.hpp>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// An archetype is the table holding every actor with one particular set of
+// attributes. Adding or removing an attribute moves actors to a neighbouring
+// archetype; the transitions are cached as edges holding the precomputed
+// list of shared fields to copy.
+class Archetype {
+public:
+
+  using Key = std::vector<std::string>;
+
+  Archetype(const Key& key, ActorType&& type, std::shared_ptr<ActorSet> id_pool);
+
+  Archetype(const Archetype&) = delete;
+  auto operator = (const Archetype&) ->Archetype& = delete;
+
+  auto key() const ->const Key&;
+  auto type() ->ActorType&;
+  auto table() ->Table&;
+
+private:
+
+  friend class ArchetypeStore;
+
+  struct FieldCopy_ {
+    int src_offset,
+        dst_offset,
+        size;
+  };
+
+  struct Edge_ {
+    Archetype*              target;
+    std::vector<FieldCopy_> copies;
+    std::vector<FieldCopy_> buffered_copies;
+    std::vector<std::pair<const Attribute*, const Attribute*>> cold_copies;
+    std::vector<std::pair<const Attribute*, const Attribute*>> column_copies;
+  };
+
+  Key                                    key_;
+  std::unique_ptr<ActorType>             type_;
+  Table                                  table_;
+  std::unordered_map<std::string, Edge_> add_edges_;
+  std::unordered_map<std::string, Edge_> remove_edges_;
+};
+
+class ArchetypeStore {
+public:
+
+  ArchetypeStore();
+
+  // Returns the archetype for the given attribute set, creating it if
+  // needed. Attributes are identified by name, and a name must always refer
+  // to the same attribute type.
+  auto archetype(const std::vector<Attribute>& attributes) ->Archetype&;
+
+  auto spawn(Archetype& archetype, int n) ->ActorSet;
+  void despawn(Archetype& archetype, const ActorSet& ids);
+
+  // Moves the actors in ids from the archetype from to the archetype having
+  // one attribute more or less, and returns the target archetype. Actor ids
+  // are unchanged, fields shared by both archetypes are copied and added
+  // fields are zero initialized. Only the current state of double-buffered
+  // fields is carried over.
+  auto addAttribute(Archetype& from, const ActorSet& ids, const Attribute& attribute) ->Archetype&;
+  auto removeAttribute(Archetype& from, const ActorSet& ids, const std::string& name) ->Archetype&;
+
+  auto numArchetypes() const ->size_t;
+
+private:
+
+  void registerAttribute_(const Attribute& attribute);
+  auto archetype_(Archetype::Key key) ->Archetype&;
+  auto edge_(Archetype& from, Archetype::Key key) ->Archetype::Edge_;
+  void move_(Archetype& from, const Archetype::Edge_& edge, const ActorSet& ids);
+
+  std::shared_ptr<ActorSet>                              id_pool_;
+  std::unordered_map<std::string, Attribute>             attributes_;
+  std::map<Archetype::Key, std::unique_ptr<Archetype>>   archetypes_;
+};
+
+#endif // archetype_hpp_INCLUDED
@@ -0,0 +1,85 @@
+#include <libcosy/mock/attribute_type.hpp>
+#include <libcosy/archetype.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+TEST_CASE("ArchetypeStore::archetype", "[ArchetypeStore]") {
+  AttributeTypeMock atm1 {"type mock 1", 4, 4};
+  AttributeTypeMock atm2 {"type mock 2", 8, 8};
+  ArchetypeStore store;
+
+  auto& a = store.archetype({
+    Attribute{.name = "b", .type = &atm1},
+    Attribute{.name = "a", .type = &atm2},
+  });
+  auto& b = store.archetype({
+    Attribute{.name = "a", .type = &atm2},
+    Attribute{.name = "b", .type = &atm1},
+  });
+  REQUIRE(&a == &b);
+  REQUIRE(a.key() == Archetype::Key{"a", "b"});
+  REQUIRE(store.numArchetypes() == 1);
+  REQUIRE_THROWS_AS(store.archetype({Attribute{.name = "a", .type = &atm1}}), std::invalid_argument);
+}
+
+TEST_CASE("ArchetypeStore: transitions", "[ArchetypeStore]") {
+  AttributeTypeMock atm {"type mock", 4, 4};
+  ArchetypeStore store;
+  auto& from = store.archetype({
+    Attribute{.name = "x", .type = &atm},
+    Attribute{.name = "y", .type = &atm},
+  });
+  auto ids = store.spawn(from, 4);
+  ids.forEach([&](ActorId id) {
+    auto rec = from.table().record(id);
+    uint32_t x = id, y = id * 10;
+    std::memcpy(rec + from.type().attribute("x")->offset, &x, 4);
+    std::memcpy(rec + from.type().attribute("y")->offset, &y, 4);
+  });
+
+  auto moved = ActorSet{2, 3};
+  auto& to = store.addAttribute(from, moved, Attribute{.name = "leader", .type = &atm});
+  REQUIRE(to.key() == Archetype::Key{"leader", "x", "y"});
+  REQUIRE(from.table().numActors() == 2);
+  REQUIRE(to.table().numActors() == 2);
+  moved.forEach([&](ActorId id) {
+    auto rec = to.table().record(id);
+    uint32_t x, y, leader;
+    std::memcpy(&x,      rec + to.type().attribute("x")->offset,      4);
+    std::memcpy(&y,      rec + to.type().attribute("y")->offset,      4);
+    std::memcpy(&leader, rec + to.type().attribute("leader")->offset, 4);
+    REQUIRE(x == id);
+    REQUIRE(y == id * 10);
+    REQUIRE(leader == 0);
+  });
+
+  SECTION("cached edges") {
+    REQUIRE(&store.addAttribute(from, ActorSet{1}, Attribute{.name = "leader", .type = &atm}) == &to);
+    REQUIRE(store.numArchetypes() == 2);
+  }
+  SECTION("redefined attribute on a cached edge") {
+    AttributeTypeMock other {"other mock", 8, 8};
+    REQUIRE_THROWS_AS(
+      store.addAttribute(from, ActorSet{1}, Attribute{.name = "leader", .type = &other}), std::invalid_argument);
+    REQUIRE_THROWS_AS(
+      store.addAttribute(from, ActorSet{1}, Attribute{.name = "leader", .type = &atm, .cold = true}),
+      std::invalid_argument);
+    REQUIRE(from.table().contains(1));
+  }
+  SECTION("back transition") {
+    REQUIRE(&store.removeAttribute(to, ActorSet{2}, "leader") == &from);
+    REQUIRE(from.table().contains(2));
+    REQUIRE_THROWS_AS(store.removeAttribute(from, ActorSet{}, "leader"), std::invalid_argument);
+  }
+  SECTION("ids not in the archetype") {
+    REQUIRE_THROWS_AS(store.removeAttribute(to, ActorSet{1, 2}, "leader"), std::invalid_argument);
+    REQUIRE(to.table().numActors() == 2);
+    REQUIRE(from.table().numActors() == 2);
+  }
+  SECTION("ids stay unique") {
+    REQUIRE(!ids.contains(store.spawn(to, 1).nth(0)));
+  }
+}
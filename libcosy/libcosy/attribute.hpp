@@ -10,6 +10,23 @@ struct Attribute {
   AttributeType* type;
   int            offset;
 
+  // Double-buffered attributes are stored outside the record, in a current
+  // and a next buffer swapped at tick boundaries. Their offset is into the
+  // buffered part of the record.
+  bool           double_buffered = false;
+
+  // Cold attributes are stored compressed in a column of their own, and
+  // their offset is the index of that column.
+  bool           cold = false;
+  // Column attributes are stored in an aligned, padded column of their own
+  // for vector kernels, one lane after another, and their offset is the
+  // index of that column.
+  bool           column = false;
+
+  // Attributes in the same access group are accessed together, and are
+  // kept within one cache line when the group fits in one.
+  std::string    group;
+
   static auto lessMemoryOrder(const Attribute& a, const Attribute& b) ->bool;
 };
 
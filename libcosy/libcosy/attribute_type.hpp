@@ -9,6 +9,7 @@ public:
   const std::string name;
 
   AttributeType(const std::string& n): name(n) {}
+  virtual ~AttributeType() = default;
 
   virtual auto size()      -> int = 0;
   virtual auto alignment() -> int = 0;
@@ -0,0 +1,125 @@
+#include <libcosy/behavior.hpp>
+
+#include <algorithm>
+#include <functional>
+
+void Actor::send(ActorId to, std::span<const char> payload) const {
+  scheduler_->send(id_, to, payload);
+}
+
+auto Actor::ReceiveAwaiter::await_ready() const ->bool {
+  auto& task = scheduler_.task_(id_);
+  return task.mailbox_head < task.mailbox.size();
+}
+
+void Actor::ReceiveAwaiter::await_suspend(std::coroutine_handle<>) const {
+  scheduler_.task_(id_).wait = Scheduler::Wait_::receive;
+}
+
+auto Actor::ReceiveAwaiter::await_resume() const ->Message {
+  auto& task = scheduler_.task_(id_);
+  auto  msg  = std::move(task.mailbox[task.mailbox_head++]);
+  if (task.mailbox_head == task.mailbox.size()) {
+    task.mailbox.clear();
+    task.mailbox_head = 0;
+  }
+  return msg;
+}
+
+void Actor::SleepAwaiter::await_suspend(std::coroutine_handle<>) const {
+  scheduler_.task_(id_).wait = Scheduler::Wait_::sleep;
+  scheduler_.timers_.emplace_back(scheduler_.now_ + std::max<uint64_t>(ticks_, 1), id_);
+  ranges::push_heap(scheduler_.timers_, std::greater{});
+}
+
+Scheduler::~Scheduler() {
+  for (auto& [id, task]: tasks_) task.handle.destroy();
+}
+
+auto Scheduler::actor(ActorType& type, ActorId id) ->Actor {
+  return Actor(*this, type, id);
+}
+
+void Scheduler::spawn(Behavior behavior) {
+  auto handle = behavior.release();
+  auto id     = handle.promise().id;
+  auto [it, inserted] = tasks_.try_emplace(id);
+  if (!inserted) {
+    handle.destroy();
+    throw std::invalid_argument(std::format("actor {} already has a behavior", id));
+  }
+  it->second.handle = handle;
+  makeReady_(id, it->second);
+}
+
+void Scheduler::send(ActorId from, ActorId to, std::span<const char> payload) {
+  auto& task = task_(to);
+  task.mailbox.push_back({.from = from, .payload = std::vector<char>(payload.begin(), payload.end())});
+  if (task.wait == Wait_::receive) makeReady_(to, task);
+}
+
+auto Scheduler::tick() ->size_t {
+  ++now_;
+  while (!timers_.empty() && timers_.front().first <= now_) {
+    auto id = timers_.front().second;
+    ranges::pop_heap(timers_, std::greater{});
+    timers_.pop_back();
+    makeReady_(id, task_(id));
+  }
+  std::erase_if(waiting_, [this](ActorId id) {
+    auto& task = task_(id);
+    if (!task.check(task.pred)) return false;
+    makeReady_(id, task);
+    return true;
+  });
+
+  auto batch = std::move(ready_);
+  ready_.clear();
+  ranges::sort(batch);
+  std::exception_ptr exception;
+  for (auto id: batch) {
+    // Behaviors may spawn others while they run, so tasks_ can rehash
+    // across resume().
+    auto handle = task_(id).handle;
+    handle.resume();
+    if (!handle.done()) continue;
+    if (handle.promise().exception && !exception) exception = handle.promise().exception;
+    handle.destroy();
+    tasks_.erase(id);
+  }
+  if (exception) std::rethrow_exception(exception);
+  return batch.size();
+}
+
+auto Scheduler::now() const ->uint64_t {
+  return now_;
+}
+
+auto Scheduler::numActors() const ->size_t {
+  return tasks_.size();
+}
+
+auto Scheduler::pool(const ActorType& type) ->FramePool& {
+  auto& pool = pools_[&type];
+  if (!pool) pool = std::make_unique<FramePool>();
+  return *pool;
+}
+
+auto Scheduler::task_(ActorId id) ->Task_& {
+  auto it = tasks_.find(id);
+  if (it == tasks_.end()) throw std::invalid_argument(std::format("actor {} has no behavior", id));
+  return it->second;
+}
+
+void Scheduler::makeReady_(ActorId id, Task_& task) {
+  task.wait = Wait_::ready;
+  ready_.push_back(id);
+}
+
+void Scheduler::waitUntil_(ActorId id, bool (*check)(void*), void* pred) {
+  auto& task = task_(id);
+  task.wait  = Wait_::until;
+  task.check = check;
+  task.pred  = pred;
+  waiting_.push_back(id);
+}
@@ -0,0 +1,246 @@
+#ifndef behavior_hpp_INCLUDED
+#define behavior_hpp_INCLUDED
+
+#include <libcosy/actor_type.hpp>
+#include <libcosy/basic_types.hpp>
+#include <libcosy/frame_pool.hpp>
+
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class Scheduler;
+
+struct Message {
+  ActorId           from;
+  std::vector<char> payload;
+};
+
+// Handle to an actor, passed as the first parameter of its behavior.
+// Behaviors suspend on the awaitables it returns:
+//
+//   Behavior node(Actor self) {
+//     for (;;) {
+//       auto msg = co_await self.receive();
+//       co_await self.sleep(1);
+//     }
+//   }
+class Actor {
+public:
+
+  Actor(Scheduler& scheduler, ActorType& type, ActorId id):
+    scheduler_(&scheduler), type_(&type), id_(id) {}
+
+  auto id() const ->ActorId           { return id_; }
+  auto type() const ->ActorType&      { return *type_; }
+  auto scheduler() const ->Scheduler& { return *scheduler_; }
+
+  void send(ActorId to, std::span<const char> payload) const;
+
+  class ReceiveAwaiter {
+  public:
+
+    ReceiveAwaiter(Scheduler& scheduler, ActorId id): scheduler_(scheduler), id_(id) {}
+
+    auto await_ready() const ->bool;
+    void await_suspend(std::coroutine_handle<>) const;
+    auto await_resume() const ->Message;
+
+  private:
+
+    Scheduler& scheduler_;
+    ActorId    id_;
+  };
+
+  class SleepAwaiter {
+  public:
+
+    SleepAwaiter(Scheduler& scheduler, ActorId id, uint64_t ticks):
+      scheduler_(scheduler), id_(id), ticks_(ticks) {}
+
+    auto await_ready() const ->bool { return false; }
+    void await_suspend(std::coroutine_handle<>) const;
+    void await_resume() const {}
+
+  private:
+
+    Scheduler& scheduler_;
+    ActorId    id_;
+    uint64_t   ticks_;
+  };
+
+  template<class Pred>
+  class UntilAwaiter {
+  public:
+
+    UntilAwaiter(Scheduler& scheduler, ActorId id, Pred pred):
+      scheduler_(scheduler), id_(id), pred_(std::move(pred)) {}
+
+    auto await_ready() ->bool { return pred_(); }
+    void await_suspend(std::coroutine_handle<>);
+    void await_resume() const {}
+
+  private:
+
+    static auto check_(void* pred) ->bool { return (*static_cast<Pred*>(pred))(); }
+
+    Scheduler& scheduler_;
+    ActorId    id_;
+    Pred       pred_;
+  };
+
+  // Resumes once a message has arrived and returns it.
+  auto receive() const ->ReceiveAwaiter {
+    return ReceiveAwaiter(*scheduler_, id_);
+  }
+
+  // Resumes after the given number of ticks.
+  auto sleep(uint64_t ticks) const ->SleepAwaiter {
+    return SleepAwaiter(*scheduler_, id_, ticks);
+  }
+
+  // Resumes at the first tick the predicate holds. Predicates of waiting
+  // actors are polled every tick.
+  template<class Pred> requires std::predicate<Pred&>
+  auto until(Pred pred) const ->UntilAwaiter<Pred> {
+    return UntilAwaiter<Pred>(*scheduler_, id_, std::move(pred));
+  }
+
+private:
+
+  Scheduler* scheduler_;
+  ActorType* type_;
+  ActorId    id_;
+};
+
+// Coroutine type of actor behaviors. Frames are allocated from the frame
+// pool of the actor's type, which requires the behavior to take its Actor
+// as the first parameter.
+class Behavior {
+public:
+
+  struct promise_type {
+
+    template<class... Args>
+    promise_type(const Actor& self, const Args&...): id(self.id()) {}
+
+    template<class... Args>
+    static auto operator new(size_t size, const Actor& self, const Args&...) ->void*;
+    static void operator delete(void* ptr, size_t size);
+
+    auto get_return_object() ->Behavior {
+      return Behavior(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    auto initial_suspend() ->std::suspend_always { return {}; }
+    auto final_suspend() noexcept ->std::suspend_always { return {}; }
+    void return_void() {}
+    void unhandled_exception() { exception = std::current_exception(); }
+
+    ActorId            id;
+    std::exception_ptr exception;
+  };
+
+  Behavior(Behavior&& other): handle_(std::exchange(other.handle_, nullptr)) {}
+  Behavior(const Behavior&) = delete;
+  ~Behavior() { if (handle_) handle_.destroy(); }
+
+  auto release() ->std::coroutine_handle<promise_type> {
+    return std::exchange(handle_, nullptr);
+  }
+
+private:
+
+  Behavior(std::coroutine_handle<promise_type> handle): handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+// Runs actor behaviors in ticks. All actors becoming ready during a tick
+// are resumed together at the next one, in order of actor id so that runs
+// are deterministic. Ids are not slots: once a table has removed or
+// reordered actors, id order says nothing about where their records lie.
+class Scheduler {
+public:
+
+  Scheduler() = default;
+  Scheduler(const Scheduler&) = delete;
+  auto operator = (const Scheduler&) ->Scheduler& = delete;
+  ~Scheduler();
+
+  auto actor(ActorType& type, ActorId id) ->Actor;
+
+  // Starts a behavior. It first runs at the next tick.
+  void spawn(Behavior behavior);
+
+  // Delivers a message to an actor, making it ready if it is receiving.
+  void send(ActorId from, ActorId to, std::span<const char> payload);
+
+  // Resumes every ready actor once and returns how many there were.
+  // Exceptions escaping a behavior are rethrown once its batch is done.
+  auto tick() ->size_t;
+
+  auto now() const ->uint64_t;
+  auto numActors() const ->size_t;
+  auto pool(const ActorType&) ->FramePool&;
+
+private:
+
+  friend class Actor;
+
+  enum class Wait_: uint8_t {
+    ready,
+    receive,
+    sleep,
+    until,
+  };
+
+  struct Task_ {
+    std::coroutine_handle<Behavior::promise_type> handle;
+    Wait_                                         wait;
+    size_t                                        mailbox_head = 0;
+    std::vector<Message>                          mailbox;
+    bool                                          (*check)(void*) = nullptr;
+    void*                                         pred = nullptr;
+  };
+
+  auto task_(ActorId id) ->Task_&;
+  void makeReady_(ActorId id, Task_& task);
+  void waitUntil_(ActorId id, bool (*check)(void*), void* pred);
+
+  std::unordered_map<const ActorType*, std::unique_ptr<FramePool>> pools_;
+  std::unordered_map<ActorId, Task_>                                tasks_;
+  std::vector<ActorId>                                              ready_;
+  std::vector<std::pair<uint64_t, ActorId>>                         timers_;
+  std::vector<ActorId>                                              waiting_;
+  uint64_t                                                          now_ = 0;
+};
+
+namespace behavior_detail {
+  // Frames are prefixed with the pool they came from, so that they can be
+  // returned to it.
+  constexpr size_t frame_header = alignof(std::max_align_t);
+}
+
+template<class... Args>
+auto Behavior::promise_type::operator new(size_t size, const Actor& self, const Args&...) ->void* {
+  auto& pool = self.scheduler().pool(self.type());
+  auto  ptr  = static_cast<char*>(pool.allocate(size + behavior_detail::frame_header));
+  *reinterpret_cast<FramePool**>(ptr) = &pool;
+  return ptr + behavior_detail::frame_header;
+}
+
+inline void Behavior::promise_type::operator delete(void* ptr, size_t size) {
+  auto base = static_cast<char*>(ptr) - behavior_detail::frame_header;
+  (*reinterpret_cast<FramePool**>(base))->deallocate(base, size + behavior_detail::frame_header);
+}
+
+template<class Pred>
+void Actor::UntilAwaiter<Pred>::await_suspend(std::coroutine_handle<>) {
+  scheduler_.waitUntil_(id_, &UntilAwaiter::check_, &pred_);
+}
+
+#endif // behavior_hpp_INCLUDED
@@ -0,0 +1,93 @@
+#include <libcosy/mock/attribute_type.hpp>
+#include <libcosy/behavior.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <stdexcept>
+#include <string>
+
+namespace {
+  auto pinger_(Actor self, ActorId peer, std::vector<std::string>& log) ->Behavior {
+    self.send(peer, std::span("ping", 4));
+    auto msg = co_await self.receive();
+    log.push_back(std::format("{}: {} at {}", self.id(), std::string(msg.payload.begin(), msg.payload.end()), self.scheduler().now()));
+  }
+
+  auto ponger_(Actor self, std::vector<std::string>& log) ->Behavior {
+    auto msg = co_await self.receive();
+    log.push_back(std::format("{}: {} at {}", self.id(), std::string(msg.payload.begin(), msg.payload.end()), self.scheduler().now()));
+    co_await self.sleep(2);
+    self.send(msg.from, std::span("pong", 4));
+  }
+
+  auto waiter_(Actor self, const bool& flag, std::vector<std::string>& log) ->Behavior {
+    co_await self.until([&flag] { return flag; });
+    log.push_back(std::format("{}: flag at {}", self.id(), self.scheduler().now()));
+  }
+
+  auto sleeper_(Actor self) ->Behavior {
+    co_await self.sleep(1);
+  }
+
+  // Spawns enough behaviors to rehash the scheduler's tasks, then ends.
+  auto spawner_(Actor self, ActorType& type, int n) ->Behavior {
+    for (int i = 0; i < n; ++i) self.scheduler().spawn(sleeper_(self.scheduler().actor(type, self.id() + 1 + i)));
+    co_return;
+  }
+
+  auto thrower_(Actor self) ->Behavior {
+    co_await self.sleep(1);
+    throw std::runtime_error("thrower");
+  }
+}
+
+TEST_CASE("Scheduler", "[Scheduler]") {
+  AttributeTypeMock atm {"type mock", 4, 4};
+  ActorType type("node", RecordType{Attribute{.name = "attr", .type = &atm}});
+  Scheduler scheduler;
+  std::vector<std::string> log;
+
+  SECTION("messages and timers") {
+    scheduler.spawn(ponger_(scheduler.actor(type, 2), log));
+    scheduler.spawn(pinger_(scheduler.actor(type, 1), 2, log));
+    REQUIRE(scheduler.pool(type).numAllocated() == 2);
+
+    REQUIRE(scheduler.tick() == 2);
+    REQUIRE(log == std::vector<std::string>{"2: ping at 1"});
+    REQUIRE(scheduler.tick() == 0);
+    REQUIRE(scheduler.tick() == 1);
+    REQUIRE(scheduler.tick() == 1);
+    REQUIRE(log == std::vector<std::string>{"2: ping at 1", "1: pong at 4"});
+    REQUIRE(scheduler.numActors() == 0);
+    REQUIRE(scheduler.pool(type).numAllocated() == 0);
+  }
+  SECTION("conditions") {
+    bool flag = false;
+    scheduler.spawn(waiter_(scheduler.actor(type, 1), flag, log));
+    scheduler.tick();
+    scheduler.tick();
+    REQUIRE(log.empty());
+    flag = true;
+    scheduler.tick();
+    REQUIRE(log == std::vector<std::string>{"1: flag at 3"});
+  }
+  SECTION("exceptions") {
+    scheduler.spawn(thrower_(scheduler.actor(type, 1)));
+    scheduler.tick();
+    REQUIRE_THROWS_AS(scheduler.tick(), std::runtime_error);
+    REQUIRE(scheduler.numActors() == 0);
+  }
+  SECTION("spawning from a behavior") {
+    scheduler.spawn(spawner_(scheduler.actor(type, 1), type, 100));
+    REQUIRE(scheduler.tick() == 1);
+    REQUIRE(scheduler.numActors() == 100);
+    REQUIRE(scheduler.tick() == 100);
+    REQUIRE(scheduler.tick() == 100);
+    REQUIRE(scheduler.numActors() == 0);
+  }
+  SECTION("one behavior per actor") {
+    bool flag = true;
+    scheduler.spawn(waiter_(scheduler.actor(type, 1), flag, log));
+    REQUIRE_THROWS_AS(scheduler.spawn(waiter_(scheduler.actor(type, 1), flag, log)), std::invalid_argument);
+  }
+}
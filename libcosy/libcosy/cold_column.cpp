@@ -0,0 +1,197 @@
+#include <libcosy/cold_column.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace {
+  constexpr size_t max_dictionary_size_ = 16;
+
+  auto bitWidth_(uint64_t n) ->uint8_t {
+    return std::bit_width(n);
+  }
+
+  auto unpack_(const std::vector<uint64_t>& packed, size_t idx, uint8_t bits) ->uint64_t {
+    if (bits == 0) return 0;
+    auto pos  = idx * bits;
+    auto word = pos / 64;
+    auto off  = pos % 64;
+    auto val  = packed[word] >> off;
+    if (off + bits > 64) val |= packed[word + 1] << (64 - off);
+    return bits == 64? val : val & ((uint64_t(1) << bits) - 1);
+  }
+
+  void pack_(std::vector<uint64_t>& packed, size_t idx, uint8_t bits, uint64_t val) {
+    auto pos  = idx * bits;
+    auto word = pos / 64;
+    auto off  = pos % 64;
+    packed[word] |= val << off;
+    if (off + bits > 64) packed[word + 1] |= val >> (64 - off);
+  }
+}
+
+ColdColumn::ColdColumn(size_t width): width_(width) {}
+
+auto ColdColumn::size() const ->size_t {
+  return size_;
+}
+
+auto ColdColumn::width() const ->size_t {
+  return width_;
+}
+
+// Values past the size of the column are kept zero, so growing only has to
+// add blocks. New blocks are all zeros, which frame of reference encodes in
+// no space.
+void ColdColumn::resize(size_t size) {
+  auto num_blocks = (size + block_size - 1) / block_size;
+  if (size < size_ && size % block_size != 0) {
+    auto b     = size / block_size;
+    auto first = size % block_size;
+    open_(b);
+    if (blocks_[b].encoding == Encoding_::raw)
+      std::fill(open_raw_.begin() + first * width_, open_raw_.end(), 0);
+    else
+      std::fill(open_vals_.begin() + first, open_vals_.end(), 0);
+  }
+  if (open_block_ != no_block_ && open_block_ >= num_blocks) open_block_ = no_block_;
+  auto old_blocks = blocks_.size();
+  blocks_.resize(num_blocks);
+  for (auto b = old_blocks; b < num_blocks; ++b) {
+    if (width_ == 1 || width_ == 2 || width_ == 4 || width_ == 8) continue;
+    blocks_[b].encoding = Encoding_::raw;
+    blocks_[b].raw.assign(block_size * width_, 0);
+  }
+  size_ = size;
+}
+
+void ColdColumn::move(size_t from, size_t to) {
+  char val[8];
+  if (width_ <= sizeof(val)) {
+    get(from, val);
+    set(to, val);
+  } else {
+    std::vector<char> buf(width_);
+    get(from, buf.data());
+    set(to, buf.data());
+  }
+}
+
+void ColdColumn::get(size_t idx, char* out) const {
+  auto b = idx / block_size;
+  auto i = idx % block_size;
+  if (b == open_block_) {
+    if (blocks_[b].encoding == Encoding_::raw) std::memcpy(out, &open_raw_[i * width_], width_);
+    else store_(open_vals_[i], out);
+  } else if (blocks_[b].encoding == Encoding_::raw) {
+    std::memcpy(out, &blocks_[b].raw[i * width_], width_);
+  } else {
+    store_(value_(blocks_[b], i), out);
+  }
+}
+
+void ColdColumn::set(size_t idx, const char* in) {
+  auto b = idx / block_size;
+  auto i = idx % block_size;
+  open_(b);
+  if (blocks_[b].encoding == Encoding_::raw) std::memcpy(&open_raw_[i * width_], in, width_);
+  else open_vals_[i] = load_(in);
+}
+
+void ColdColumn::decode(size_t first, size_t count, char* out) const {
+  for (auto idx = first; idx < first + count;) {
+    auto b    = idx / block_size;
+    auto i    = idx % block_size;
+    auto last = std::min(first + count, (b + 1) * block_size);
+    const auto& block = blocks_[b];
+    if (b == open_block_ || block.encoding == Encoding_::raw) {
+      for (; idx < last; ++idx, out += width_) get(idx, out);
+      continue;
+    }
+    for (; idx < last; ++idx, ++i, out += width_) {
+      auto code = unpack_(block.packed, i, block.bits);
+      store_(block.encoding == Encoding_::dictionary? block.dictionary[code] : block.base + code, out);
+    }
+  }
+}
+
+void ColdColumn::flush() {
+  if (open_block_ == no_block_) return;
+  auto& block = blocks_[open_block_];
+  if (block.encoding == Encoding_::raw) block.raw = open_raw_;
+  else encode_(block, open_vals_.data(), block_size);
+  open_block_ = no_block_;
+}
+
+auto ColdColumn::compressedSize() const ->size_t {
+  size_t size = 0;
+  for (const auto& block: blocks_) {
+    size += sizeof(Block_);
+    size += (block.dictionary.size() + block.packed.size()) * sizeof(uint64_t);
+    size += block.raw.size();
+  }
+  return size;
+}
+
+auto ColdColumn::load_(const char* in) const ->uint64_t {
+  uint64_t val = 0;
+  std::memcpy(&val, in, width_);
+  return val;
+}
+
+void ColdColumn::store_(uint64_t val, char* out) const {
+  std::memcpy(out, &val, width_);
+}
+
+auto ColdColumn::value_(const Block_& block, size_t idx) const ->uint64_t {
+  auto code = unpack_(block.packed, idx, block.bits);
+  return block.encoding == Encoding_::dictionary? block.dictionary[code] : block.base + code;
+}
+
+void ColdColumn::encode_(Block_& block, const uint64_t* vals, size_t count) {
+  auto [min, max] = std::minmax_element(vals, vals + count);
+  auto for_bits = bitWidth_(*max - *min);
+
+  std::vector<uint64_t> dictionary;
+  for (size_t i = 0; i < count && dictionary.size() <= max_dictionary_size_; ++i) {
+    if (std::ranges::find(dictionary, vals[i]) == dictionary.end()) dictionary.push_back(vals[i]);
+  }
+  auto dict_bits = bitWidth_(dictionary.size() - 1);
+  bool use_dictionary =
+    dictionary.size() <= max_dictionary_size_ &&
+    dict_bits * count + dictionary.size() * 64 < for_bits * count;
+
+  block.dictionary.clear();
+  if (use_dictionary) {
+    std::ranges::sort(dictionary);
+    block.encoding   = Encoding_::dictionary;
+    block.bits       = dict_bits;
+    block.dictionary = std::move(dictionary);
+  } else {
+    block.encoding = Encoding_::frame_of_reference;
+    block.bits     = for_bits;
+    block.base     = *min;
+  }
+  block.packed.assign((count * block.bits + 63) / 64, 0);
+  if (block.bits == 0) return;
+  for (size_t i = 0; i < count; ++i) {
+    auto code = use_dictionary
+      ? std::ranges::lower_bound(block.dictionary, vals[i]) - block.dictionary.begin()
+      : vals[i] - block.base;
+    pack_(block.packed, i, block.bits, code);
+  }
+  block.packed.shrink_to_fit();
+}
+
+void ColdColumn::open_(size_t b) {
+  if (open_block_ == b) return;
+  flush();
+  const auto& block = blocks_[b];
+  if (block.encoding == Encoding_::raw) {
+    open_raw_ = block.raw;
+  } else {
+    open_vals_.resize(block_size);
+    for (size_t i = 0; i < block_size; ++i) open_vals_[i] = value_(block, i);
+  }
+  open_block_ = b;
+}
@@ -0,0 +1,74 @@
+#ifndef cold_column_hpp_INCLUDED
+#define cold_column_hpp_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Block-compressed column for rarely accessed attributes. Values of 1, 2, 4
+// or 8 bytes are treated as unsigned integers and each block of values is
+// either dictionary encoded or bit-packed relative to its minimum, whichever
+// is smaller. Values of other sizes are stored uncompressed.
+//
+// Single values are decoded in place. Writes go to one decompressed block
+// which is compressed again when another block is written to or on
+// flush().
+class ColdColumn {
+public:
+
+  static constexpr size_t block_size = 256;
+
+  ColdColumn(size_t width);
+
+  auto size() const ->size_t;
+  auto width() const ->size_t;
+
+  // Grows with zero values or shrinks the column.
+  void resize(size_t size);
+
+  void get(size_t idx, char* out) const;
+  void set(size_t idx, const char* in);
+  void move(size_t from, size_t to);
+
+  // Decodes the values [first, first + count) into out.
+  void decode(size_t first, size_t count, char* out) const;
+
+  void flush();
+
+  auto compressedSize() const ->size_t;
+
+private:
+
+  enum class Encoding_: uint8_t {
+    frame_of_reference,
+    dictionary,
+    raw,
+  };
+
+  struct Block_ {
+    Encoding_             encoding = Encoding_::frame_of_reference;
+    uint8_t               bits     = 0;
+    uint64_t              base     = 0;
+    std::vector<uint64_t> dictionary;
+    std::vector<uint64_t> packed;
+    std::vector<char>     raw;
+  };
+
+  auto load_(const char* in) const ->uint64_t;
+  void store_(uint64_t val, char* out) const;
+  auto value_(const Block_& block, size_t idx) const ->uint64_t;
+  void encode_(Block_& block, const uint64_t* vals, size_t count);
+  void open_(size_t block);
+
+  size_t              width_;
+  size_t              size_ = 0;
+  std::vector<Block_> blocks_;
+
+  // The decompressed block taking writes, if any.
+  static constexpr size_t no_block_ = -1;
+  size_t                  open_block_ = no_block_;
+  std::vector<uint64_t>   open_vals_;
+  std::vector<char>       open_raw_;
+};
+
+#endif // cold_column_hpp_INCLUDED
@@ -0,0 +1,75 @@
+#include <libcosy/cold_column.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstring>
+#include <vector>
+
+namespace {
+  template<class T>
+  auto get(const ColdColumn& column, size_t idx) ->T {
+    T val;
+    column.get(idx, reinterpret_cast<char*>(&val));
+    return val;
+  }
+
+  template<class T>
+  void set(ColdColumn& column, size_t idx, T val) {
+    column.set(idx, reinterpret_cast<const char*>(&val));
+  }
+}
+
+TEST_CASE("ColdColumn::resize", "[ColdColumn]") {
+  ColdColumn column(4);
+  column.resize(1000);
+  REQUIRE(column.size() == 1000);
+  REQUIRE(get<uint32_t>(column, 999) == 0);
+
+  set<uint32_t>(column, 300, 7);
+  set<uint32_t>(column, 301, 8);
+  column.resize(301);
+  column.resize(400);
+  REQUIRE(get<uint32_t>(column, 300) == 7);
+  REQUIRE(get<uint32_t>(column, 301) == 0);
+}
+
+TEST_CASE("ColdColumn: encodings", "[ColdColumn]") {
+  auto n = ColdColumn::block_size * 4;
+
+  SECTION("frame of reference") {
+    ColdColumn column(8);
+    column.resize(n);
+    for (size_t i = 0; i < n; ++i) set<uint64_t>(column, i, 1'000'000'000 + i);
+    column.flush();
+    for (size_t i = 0; i < n; ++i) REQUIRE(get<uint64_t>(column, i) == 1'000'000'000 + i);
+    REQUIRE(column.compressedSize() < n * 8 / 4);
+  }
+  SECTION("dictionary") {
+    ColdColumn column(4);
+    column.resize(n);
+    for (size_t i = 0; i < n; ++i) set<uint32_t>(column, i, i % 3 == 0? 5 : 1'000'000);
+    column.flush();
+    for (size_t i = 0; i < n; ++i) REQUIRE(get<uint32_t>(column, i) == (i % 3 == 0? 5 : 1'000'000));
+    REQUIRE(column.compressedSize() < n);
+  }
+  SECTION("raw") {
+    ColdColumn column(3);
+    column.resize(n);
+    for (size_t i = 0; i < n; ++i) column.set(i, "abc");
+    column.flush();
+    char val[3];
+    column.get(n - 1, val);
+    REQUIRE(std::memcmp(val, "abc", 3) == 0);
+  }
+}
+
+TEST_CASE("ColdColumn::decode", "[ColdColumn]") {
+  ColdColumn column(2);
+  column.resize(600);
+  for (size_t i = 0; i < 600; ++i) set<uint16_t>(column, i, i * 3);
+  set<uint16_t>(column, 0, 1);
+
+  std::vector<uint16_t> vals(500);
+  column.decode(50, 500, reinterpret_cast<char*>(vals.data()));
+  for (size_t i = 0; i < 500; ++i) REQUIRE(vals[i] == (i + 50) * 3);
+}
@@ -0,0 +1,82 @@
+#ifndef field_view_hpp_INCLUDED
+#define field_view_hpp_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Strided views of one attribute over the slots of a Table. Views point
+// into the table's storage and are invalidated when the table grows or
+// swaps its buffers.
+class ConstFieldView {
+public:
+
+  ConstFieldView(const char* base, size_t stride): base_(base), stride_(stride) {}
+
+  auto operator [] (uint64_t slot) const ->const char* {
+    return base_ + slot * stride_;
+  }
+
+  template<class T>
+  auto get(uint64_t slot) const ->T {
+    T val;
+    std::memcpy(&val, (*this)[slot], sizeof(T));
+    return val;
+  }
+
+private:
+
+  const char* base_;
+  size_t      stride_;
+};
+
+class FieldView {
+public:
+
+  FieldView(char* base, size_t stride): base_(base), stride_(stride) {}
+
+  operator ConstFieldView () const {
+    return ConstFieldView(base_, stride_);
+  }
+
+  auto operator [] (uint64_t slot) const ->char* {
+    return base_ + slot * stride_;
+  }
+
+  template<class T>
+  auto get(uint64_t slot) const ->T {
+    T val;
+    std::memcpy(&val, (*this)[slot], sizeof(T));
+    return val;
+  }
+
+  template<class T>
+  void set(uint64_t slot, const T& val) const {
+    std::memcpy((*this)[slot], &val, sizeof(T));
+  }
+
+private:
+
+  char*  base_;
+  size_t stride_;
+};
+
+// Values of a column attribute: lane k of slot i is lane(k)[i]. Lanes are
+// aligned to Table::column_alignment and hold padded_size values, a whole
+// number of vectors, so kernels can process them without a scalar tail.
+// Values past size are padding and may be read and written freely; a
+// slot's values are zeroed when it comes into use.
+template<class T>
+struct ColumnView {
+  T*     data;
+  size_t size;
+  size_t padded_size;
+  size_t lane_stride;
+  int    lanes;
+
+  auto lane(int k) const ->T* {
+    return data + k * lane_stride;
+  }
+};
+
+#endif // field_view_hpp_INCLUDED
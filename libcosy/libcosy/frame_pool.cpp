@@ -0,0 +1,40 @@
+#include <libcosy/frame_pool.hpp>
+
+#include <algorithm>
+
+auto FramePool::allocate(size_t size) ->void* {
+  auto cls = (size + granularity - 1) / granularity;
+  if (cls >= free_lists_.size()) free_lists_.resize(cls + 1, nullptr);
+  if (free_lists_[cls] == nullptr) {
+    auto block = cls * granularity;
+    auto num   = std::max<size_t>(chunk_size / block, 1);
+    auto chunk = new char[num * block];
+    chunks_.emplace_back(chunk);
+    for (size_t i = num; i-- > 0;) {
+      auto free = reinterpret_cast<FreeBlock_*>(chunk + i * block);
+      free->next = free_lists_[cls];
+      free_lists_[cls] = free;
+    }
+    reserved_ += num * block;
+  }
+  auto block = free_lists_[cls];
+  free_lists_[cls] = block->next;
+  ++allocated_;
+  return block;
+}
+
+void FramePool::deallocate(void* ptr, size_t size) {
+  auto cls   = (size + granularity - 1) / granularity;
+  auto block = static_cast<FreeBlock_*>(ptr);
+  block->next = free_lists_[cls];
+  free_lists_[cls] = block;
+  --allocated_;
+}
+
+auto FramePool::numAllocated() const ->size_t {
+  return allocated_;
+}
+
+auto FramePool::reservedSize() const ->size_t {
+  return reserved_;
+}
@@ -0,0 +1,39 @@
+#ifndef frame_pool_hpp_INCLUDED
+#define frame_pool_hpp_INCLUDED
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Pool of fixed size blocks for coroutine frames. Sizes are rounded up to a
+// multiple of the granularity and each size class has its own free list,
+// carved out of chunks which are only released with the pool.
+class FramePool {
+public:
+
+  static constexpr size_t granularity = 64;
+  static constexpr size_t chunk_size  = 64 * 1024;
+
+  FramePool() = default;
+  FramePool(const FramePool&) = delete;
+  auto operator = (const FramePool&) ->FramePool& = delete;
+
+  auto allocate(size_t size) ->void*;
+  void deallocate(void* ptr, size_t size);
+
+  auto numAllocated() const ->size_t;
+  auto reservedSize() const ->size_t;
+
+private:
+
+  struct FreeBlock_ {
+    FreeBlock_* next;
+  };
+
+  std::vector<FreeBlock_*>               free_lists_;
+  std::vector<std::unique_ptr<char[]>>   chunks_;
+  size_t                                 reserved_  = 0;
+  size_t                                 allocated_ = 0;
+};
+
+#endif // frame_pool_hpp_INCLUDED
@@ -0,0 +1,126 @@
+#include <libcosy/history.hpp>
+
+namespace {
+  constexpr size_t slab_alignment_ = Table::column_alignment;
+  constexpr uint64_t min_rows_     = 64;
+
+  // Values in slot order, one of type W per slot.
+  template<class W>
+  void sample_(Table& table, const Attribute& attr, char* out) {
+    auto n = table.numActors();
+    if (n == 0) return;
+    if (attr.column) {
+      std::memcpy(out, table.column<W>(attr).data, n * sizeof(W));
+    } else if (attr.cold) {
+      table.cold(attr).decode(0, n, out);
+    } else {
+      auto field = attr.double_buffered? table.current(attr) : ConstFieldView(table.field(attr));
+      for (uint64_t slot = 0; slot < n; ++slot) std::memcpy(out + slot * sizeof(W), field[slot], sizeof(W));
+    }
+  }
+}
+
+AttributeHistory::AttributeHistory(Table& table, const Attribute& attr, size_t depth):
+  table_(table),
+  attr_(&attr),
+  size_(attr.type->size()),
+  depth_(depth),
+  head_(depth - 1),
+  ring_(defaultAllocator()) {
+  if (depth == 0) throw std::invalid_argument("history needs a depth of at least one tick");
+  auto primitive = dynamic_cast<PrimitiveType*>(attr.type);
+  if ((primitive != nullptr && primitive->lanes() != 1) || !(size_ == 1 || size_ == 2 || size_ == 4 || size_ == 8))
+    throw std::invalid_argument(std::format("attribute '{}' does not hold a single value", attr.name));
+}
+
+void AttributeHistory::record() {
+  sync_();
+  head_ = (head_ + 1) % depth_;
+  auto slab = ring_.data() + head_ * slab_stride_;
+  switch (size_) {
+  case 1: sample_<uint8_t>(table_, *attr_, slab);  break;
+  case 2: sample_<uint16_t>(table_, *attr_, slab); break;
+  case 4: sample_<uint32_t>(table_, *attr_, slab); break;
+  case 8: sample_<uint64_t>(table_, *attr_, slab); break;
+  }
+  ++ticks_;
+}
+
+auto AttributeHistory::depth() const ->size_t {
+  return depth_;
+}
+
+auto AttributeHistory::ticks() const ->uint64_t {
+  return ticks_;
+}
+
+auto AttributeHistory::samples(ActorId id) ->size_t {
+  sync_();
+  return samples_(row_(id));
+}
+
+// Rows still holding the actor of their slot are left alone. Every other
+// slot takes the history of its actor from the row it held before, found
+// by the version the actor was added at, or starts at the current tick.
+// All moved histories are read before any is written, since swaps and
+// reorders overwrite rows that are the source of other moves.
+void AttributeHistory::sync_() {
+  if (table_.layoutVersion() == layout_version_) return;
+  auto added = table_.addedVersions();
+  uint64_t n = added.size(), old = added_.size();
+
+  old_rows_.clear();
+  for (uint64_t row = 0; row < old; ++row)
+    if (row >= n || added_[row] != added[row]) old_rows_.emplace(added_[row], row);
+  moves_.clear();
+  for (uint64_t row = 0; row < n; ++row) {
+    if (row < old && added_[row] == added[row]) continue;
+    auto it = old_rows_.find(added[row]);
+    if (it == old_rows_.end()) moves_.push_back({row, no_row, ticks_});
+    else                      moves_.push_back({row, it->second, since_[it->second]});
+  }
+
+  reserveRows_(n);
+  moved_.resize(moves_.size() * depth_ * size_);
+  auto pos = moved_.data();
+  for (auto& move : moves_) {
+    if (move.from == no_row) continue;
+    for (size_t s = 0; s < depth_; ++s, pos += size_)
+      std::memcpy(pos, ring_.data() + s * slab_stride_ + move.from * size_, size_);
+  }
+  pos = moved_.data();
+  for (auto& move : moves_) {
+    since_[move.row] = move.since;
+    if (move.from == no_row) continue;
+    for (size_t s = 0; s < depth_; ++s, pos += size_)
+      std::memcpy(ring_.data() + s * slab_stride_ + move.row * size_, pos, size_);
+  }
+  added_.assign(added.begin(), added.end());
+  layout_version_ = table_.layoutVersion();
+}
+
+// Growing the slabs copies the ring once; capacity doubles so that this
+// happens a logarithmic number of times.
+void AttributeHistory::reserveRows_(uint64_t n) {
+  if (n <= row_capacity_) return;
+  auto capacity = std::max(min_rows_, row_capacity_);
+  while (capacity < n) capacity *= 2;
+  auto stride = (capacity * size_ + slab_alignment_ - 1) / slab_alignment_ * slab_alignment_;
+  Storage ring(ring_.allocatorPtr());
+  ring.resize(depth_ * stride);
+  for (size_t s = 0; s < depth_ && row_capacity_ > 0; ++s)
+    std::memcpy(ring.data() + s * stride, ring_.data() + s * slab_stride_, row_capacity_ * size_);
+  ring_         = std::move(ring);
+  slab_stride_  = stride;
+  row_capacity_ = capacity;
+  since_.resize(capacity);
+}
+
+auto AttributeHistory::row_(ActorId id) const ->uint64_t {
+  if (!table_.contains(id)) throw std::out_of_range(std::format("no history of actor {}", id));
+  return table_.slot(id);
+}
+
+auto AttributeHistory::slab_(size_t age) const ->const char* {
+  return ring_.data() + (head_ + depth_ - age) % depth_ * slab_stride_;
+}
@@ -0,0 +1,194 @@
+#ifndef history_hpp_INCLUDED
+#define history_hpp_INCLUDED
+
+#include <libcosy/table.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// The values of one attribute over the last depth ticks. Each call to
+// record() samples the attribute for every actor of the table into a slab,
+// one value per actor stored contiguously, and slabs are kept in a ring
+// that overwrites the oldest tick. Memory is bounded by depth slabs of the
+// largest number of actors sampled at once. The table and the attribute
+// must outlive the history.
+//
+// Row r of every slab holds the actor in slot r of the table, so recording
+// a tick is one copy of a column attribute, or one pass over the records
+// for other attributes. When the layout of the table changed since the
+// last record() or query, rows are remapped first: one pass comparing the
+// added versions of the slots, then a copy of depth values for each actor
+// now in another slot. Removing k actors moves at most k others, so churn
+// costs O(k * depth) on top of the pass; a reorder() moves most actors and
+// costs up to one copy of the ring.
+//
+// Window queries run over blocks of actors, gathering the values of each
+// tick into contiguous arrays which the kernels then run over, as in
+// reduce.hpp.
+class AttributeHistory {
+public:
+
+  // The attribute must hold a single value of 1, 2, 4 or 8 bytes.
+  AttributeHistory(Table& table, const Attribute& attr, size_t depth);
+
+  AttributeHistory(const AttributeHistory&) = delete;
+  auto operator = (const AttributeHistory&) ->AttributeHistory& = delete;
+
+  // Samples the current value of the attribute for all actors as the
+  // newest tick. Double-buffered attributes are read from their current
+  // state.
+  void record();
+
+  // The number of ticks kept, and the number recorded so far.
+  auto depth() const ->size_t;
+  auto ticks() const ->uint64_t;
+
+  // The number of ticks held for an actor, at most depth, and 0 for actors
+  // added since the last record(). Queries cover the actors of the table;
+  // other ids throw std::out_of_range, as do actors without samples in
+  // window queries.
+  auto samples(ActorId) ->size_t;
+
+  // The value of an actor age ticks ago, where age 0 is the newest sample.
+  template<class T>
+  auto value(ActorId id, size_t age) ->T {
+    checkType_<T>();
+    sync_();
+    auto row = row_(id);
+    if (age >= samples_(row)) throw std::out_of_range(std::format("no sample of actor {} at age {}", id, age));
+    T val;
+    std::memcpy(&val, slab_(age) + row * sizeof(T), sizeof(T));
+    return val;
+  }
+
+  // The mean of the last window samples of each actor in ids, in id
+  // order. Actors with fewer samples are averaged over those they have.
+  template<class T>
+  auto movingAverage(const ActorSet& ids, size_t window) ->std::vector<double> {
+    checkType_<T>();
+    if (window == 0) throw std::invalid_argument("window must not be empty");
+    sync_();
+    window = std::min<size_t>(window, std::min<uint64_t>(ticks_, depth_));
+    std::vector<double> res;
+    res.reserve(ids.size());
+    forBlocks_(ids, [&](const uint64_t* rows, const uint64_t* counts, size_t n) {
+      T      vals[block_size];
+      double sums[block_size];
+      for (size_t i = 0; i < n; ++i) sums[i] = 0;
+      for (size_t age = 0; age < window; ++age) {
+        gather_(slab_(age), rows, n, vals);
+        for (size_t i = 0; i < n; ++i) sums[i] += age < counts[i]? double(vals[i]) : 0.0;
+      }
+      for (size_t i = 0; i < n; ++i) res.push_back(sums[i] / double(std::min<uint64_t>(counts[i], window)));
+    });
+    return res;
+  }
+
+  // For each actor in ids, in id order, the age of its newest sample that
+  // differs from the sample before it: 0 if the value changed in the last
+  // recorded tick. Actors whose value did not change within their samples
+  // get their number of samples.
+  template<class T>
+  auto lastChange(const ActorSet& ids) ->std::vector<uint64_t> {
+    checkType_<T>();
+    sync_();
+    std::vector<uint64_t> res;
+    res.reserve(ids.size());
+    auto held = std::min<uint64_t>(ticks_, depth_);
+    forBlocks_(ids, [&](const uint64_t* rows, const uint64_t* counts, size_t n) {
+      T        a[block_size], b[block_size];
+      uint64_t ages[block_size];
+      T*       newer = a;
+      T*       older = b;
+      for (size_t i = 0; i < n; ++i) ages[i] = counts[i];
+      gather_(slab_(0), rows, n, newer);
+      for (uint64_t age = 1; age < held; ++age) {
+        gather_(slab_(age), rows, n, older);
+        for (size_t i = 0; i < n; ++i) {
+          bool first = ages[i] == counts[i] && age < counts[i] && newer[i] != older[i];
+          ages[i] = first? age - 1 : ages[i];
+        }
+        std::swap(newer, older);
+      }
+      res.insert(res.end(), ages, ages + n);
+    });
+    return res;
+  }
+
+private:
+
+  static constexpr size_t block_size = 256;
+
+  static constexpr uint64_t no_row = std::numeric_limits<uint64_t>::max();
+
+  // A row whose history comes from another row, or starts now if from is
+  // no_row.
+  struct Move_ {
+    uint64_t row;
+    uint64_t from;
+    uint64_t since;
+  };
+
+  void sync_();
+  void reserveRows_(uint64_t n);
+  auto row_(ActorId) const ->uint64_t;
+  auto slab_(size_t age) const ->const char*;
+
+  auto samples_(uint64_t row) const ->uint64_t {
+    return std::min<uint64_t>(ticks_ - since_[row], depth_);
+  }
+
+  template<class T>
+  void checkType_() const {
+    static_assert(std::is_arithmetic_v<T>);
+    if (sizeof(T) != size_)
+      throw std::invalid_argument(std::format("attribute '{}' has values of {} bytes", attr_->name, size_));
+  }
+
+  template<class T>
+  static void gather_(const char* slab, const uint64_t* rows, size_t n, T* out) {
+    for (size_t i = 0; i < n; ++i) std::memcpy(out + i, slab + rows[i] * sizeof(T), sizeof(T));
+  }
+
+  // Calls fn(rows, counts, n) on blocks of the rows and sample counts of
+  // ids, in id order.
+  template<class Fn>
+  void forBlocks_(const ActorSet& ids, Fn fn) const {
+    uint64_t rows[block_size], counts[block_size];
+    size_t   n = 0;
+    ids.forEach([&](ActorId id) {
+      rows[n]   = row_(id);
+      counts[n] = samples_(rows[n]);
+      if (counts[n] == 0) throw std::out_of_range(std::format("no samples of actor {}", id));
+      if (++n == block_size) {
+        fn(rows, counts, n);
+        n = 0;
+      }
+    });
+    if (n > 0) fn(rows, counts, n);
+  }
+
+  Table&                                 table_;
+  const Attribute*                       attr_;
+  size_t                                 size_;
+  size_t                                 depth_;
+  uint64_t                               ticks_ = 0;
+  size_t                                 head_;
+  Storage                                ring_;
+  size_t                                 slab_stride_ = 0;
+  uint64_t                               row_capacity_ = 0;
+  std::vector<uint64_t>                  added_;
+  std::vector<uint64_t>                  since_;
+  uint64_t                               layout_version_ = std::numeric_limits<uint64_t>::max();
+  std::unordered_map<uint64_t, uint64_t> old_rows_;
+  std::vector<Move_>                     moves_;
+  std::vector<char>                      moved_;
+};
+
+#endif // history_hpp_INCLUDED
@@ -0,0 +1,107 @@
+#include <libcosy/mock/attribute_type.hpp>
+#include <libcosy/history.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <stdexcept>
+
+TEST_CASE("AttributeHistory", "[AttributeHistory]") {
+  AttributeTypeMock atm {"type mock", 4, 4};
+  auto& types = TypeRegistry::global();
+  ActorType type("actor", RecordType{
+    Attribute{.name = "val", .type = &atm},
+    Attribute{.name = "col", .type = types.get("f32"), .column = true},
+    Attribute{.name = "pos", .type = types.get("vec2"), .column = true},
+  });
+  auto& val = *type.attribute("val");
+  auto& col = *type.attribute("col");
+  Table table(&type);
+  table.newActors(4);
+
+  REQUIRE_THROWS_AS(AttributeHistory(table, *type.attribute("pos"), 3), std::invalid_argument);
+  AttributeHistory vals(table, val, 3);
+  AttributeHistory cols(table, col, 3);
+  REQUIRE(vals.samples(1) == 0);
+  REQUIRE_THROWS_AS(vals.samples(99), std::out_of_range);
+  REQUIRE_THROWS_AS(vals.movingAverage<int32_t>(ActorSet{1}, 1), std::out_of_range);
+
+  // val of actor i at tick t is i * t, col changes for actor 2 only.
+  for (uint32_t tick = 0; tick < 5; ++tick) {
+    for (ActorId id = 1; id <= 4; ++id) {
+      table.field(val).set<int32_t>(table.slot(id), int32_t(id * tick));
+      table.column<float>(col).data[table.slot(id)] = id == 2? float(tick) : 1.f;
+    }
+    vals.record();
+    cols.record();
+  }
+  REQUIRE(vals.ticks() == 5);
+  REQUIRE(vals.samples(1) == 3);
+  REQUIRE(vals.value<int32_t>(3, 0) == 12);
+  REQUIRE(vals.value<int32_t>(3, 2) == 6);
+  REQUIRE_THROWS_AS(vals.value<int32_t>(3, 3), std::out_of_range);
+  REQUIRE_THROWS_AS(vals.value<int64_t>(3, 0), std::invalid_argument);
+
+  REQUIRE(vals.movingAverage<int32_t>(ActorSet{1, 3}, 2) == std::vector<double>{3.5, 10.5});
+  REQUIRE(vals.movingAverage<int32_t>(ActorSet{2}, 10) == std::vector<double>{6});
+  REQUIRE(cols.lastChange<float>(ActorSet{1, 2}) == std::vector<uint64_t>{3, 0});
+
+  // Removed actors lose their history and new ones start without one.
+  table.deleteActor(1);
+  auto added = table.newActor();
+  table.field(val).set<int32_t>(table.slot(added), 100);
+  table.column<float>(col).data[table.slot(added)] = 7.f;
+  for (ActorId id = 2; id <= 4; ++id)
+    table.field(val).set<int32_t>(table.slot(id), int32_t(id * 5));
+  vals.record();
+  cols.record();
+  REQUIRE(vals.samples(added) == 1);
+  REQUIRE(vals.value<int32_t>(added, 0) == 100);
+  REQUIRE(vals.value<int32_t>(4, 0) == 20);
+  REQUIRE(vals.value<int32_t>(4, 1) == 16);
+  REQUIRE(vals.movingAverage<int32_t>(ActorSet{added}, 3) == std::vector<double>{100});
+  REQUIRE(cols.lastChange<float>(ActorSet{added, 3}) == std::vector<uint64_t>{1, 3});
+
+  table.reorder({3, 2, 1, 0});
+  table.field(val).set<int32_t>(table.slot(4), 0);
+  vals.record();
+  REQUIRE(vals.value<int32_t>(4, 0) == 0);
+  REQUIRE(vals.value<int32_t>(4, 1) == 20);
+  REQUIRE(vals.value<int32_t>(added, 1) == 100);
+}
+
+TEST_CASE("AttributeHistory: many actors", "[AttributeHistory]") {
+  AttributeTypeMock atm {"type mock", 8, 8};
+  ActorType type("actor", RecordType{Attribute{.name = "val", .type = &atm, .double_buffered = true}});
+  auto& val = *type.attribute("val");
+  Table table(&type);
+  auto ids = table.newActors(1000);
+
+  AttributeHistory history(table, val, 4);
+  for (uint64_t tick = 0; tick < 6; ++tick) {
+    for (uint64_t slot = 0; slot < 1000; ++slot) table.next(val).set<double>(slot, double(slot + tick));
+    table.swapBuffers();
+    history.record();
+  }
+  auto avg = history.movingAverage<double>(ids, 4);
+  REQUIRE(avg.size() == 1000);
+  REQUIRE(avg[0] == 3.5);
+  REQUIRE(avg[999] == 1002.5);
+  auto changes = history.lastChange<double>(ids);
+  REQUIRE(changes[500] == 0);
+
+  // Histories follow the actors that removals move to other slots.
+  ActorSet removed;
+  for (ActorId id = 1; id <= 1000; id += 3) removed.insert(id);
+  removed.forEach([&](ActorId id) { table.deleteActor(id); });
+  for (uint64_t slot = 0; slot < table.numActors(); ++slot)
+    table.next(val).set<double>(slot, -double(table.actorAt(slot)));
+  table.swapBuffers();
+  history.record();
+  REQUIRE_THROWS_AS(history.samples(1), std::out_of_range);
+  REQUIRE(history.samples(1000 - 1) == 4);
+  for (ActorId id = 2; id <= 1000; ++id) {
+    if (removed.contains(id)) continue;
+    REQUIRE(history.value<double>(id, 0) == -double(id));
+    REQUIRE(history.value<double>(id, 1) == double(id - 1 + 5));
+  }
+}
@@ -1,7 +1,8 @@
 #ifndef integral_set_hpp_INCLUDED
 #define integral_set_hpp_INCLUDED
 
-#include <libcosy/iter_tools.hpp>
+#include <libcosy/parallel.hpp>
+#include <libcosy/small_vector.hpp>
 
 #include <concepts>
 #include <ranges>
@@ -12,15 +13,359 @@
 #include <cstdint>
 #include <iostream>
 #include <format>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include <array>
+
+// Varint coding used by the IntegralSet wire format.
+namespace integral_set_codec {
+
+  inline void putVarint(std::vector<char>& buf, uint64_t val) {
+    while (val >= 0x80) {
+      buf.push_back(char(val | 0x80));
+      val >>= 7;
+    }
+    buf.push_back(char(val));
+  }
+
+  inline auto getVarint(const char*& pos, const char* end) ->uint64_t {
+    uint64_t val = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (pos == end) throw std::invalid_argument("IntegralSet::decode: truncated input");
+      auto byte = uint8_t(*pos++);
+      val |= uint64_t(byte & 0x7f) << shift;
+      if (byte < 0x80) return val;
+    }
+    throw std::invalid_argument("IntegralSet::decode: malformed varint");
+  }
+
+  // Maps values to unsigned keys of the same order.
+  template<std::integral T>
+  auto key(T val) ->std::make_unsigned_t<T> {
+    using U = std::make_unsigned_t<T>;
+    if constexpr (std::is_signed_v<T>) return U(val) ^ (U(1) << (std::numeric_limits<U>::digits - 1));
+    else return val;
+  }
+
+  template<std::integral T>
+  auto value(std::make_unsigned_t<T> key) ->T {
+    using U = std::make_unsigned_t<T>;
+    if constexpr (std::is_signed_v<T>) return T(key ^ (U(1) << (std::numeric_limits<U>::digits - 1)));
+    else return key;
+  }
+}
+
+// Parallel sorting of unsorted values for bulk construction of
+// IntegralSets. Values are sorted as order-preserving unsigned keys.
+namespace integral_set_bulk {
+
+  constexpr size_t min_values_per_thread = 1 << 16;
+
+  // LSD radix sort by bytes. Bytes equal in all keys are skipped, so dense
+  // ids take only as many passes as their range needs.
+  template<std::unsigned_integral U>
+  void radixSort(std::vector<U>& keys, unsigned threads) {
+    auto n = keys.size();
+    if (n < 2) return;
+
+    std::vector<U> diffs(threads, 0);
+    forChunks(n, threads, [&keys, &diffs](unsigned t, size_t first, size_t last) {
+      U diff = 0;
+      for (auto i = first; i < last; ++i) diff |= keys[i] ^ keys[0];
+      diffs[t] = diff;
+    });
+    U diff = 0;
+    for (auto d: diffs) diff |= d;
+
+    std::vector<U> sorted(n);
+    std::vector<std::array<size_t, 256>> offsets(threads);
+    for (int shift = 0; shift < std::numeric_limits<U>::digits; shift += 8) {
+      if (((diff >> shift) & 0xff) == 0) continue;
+      forChunks(n, threads, [&keys, &offsets, shift](unsigned t, size_t first, size_t last) {
+        auto& counts = offsets[t];
+        counts.fill(0);
+        for (auto i = first; i < last; ++i) ++counts[(keys[i] >> shift) & 0xff];
+      });
+      size_t offset = 0;
+      for (size_t digit = 0; digit < 256; ++digit) {
+        for (auto& counts: offsets) {
+          auto count = counts[digit];
+          counts[digit] = offset;
+          offset += count;
+        }
+      }
+      forChunks(n, threads, [&keys, &sorted, &offsets, shift](unsigned t, size_t first, size_t last) {
+        auto& pos = offsets[t];
+        for (auto i = first; i < last; ++i) sorted[pos[(keys[i] >> shift) & 0xff]++] = keys[i];
+      });
+      keys.swap(sorted);
+    }
+  }
+
+  // Coalesces sorted keys into runs of consecutive keys, one chunk per
+  // thread. Runs of neighbouring chunks may need joining.
+  template<std::unsigned_integral U>
+  auto runs(const std::vector<U>& keys, unsigned threads) ->std::vector<std::vector<std::pair<U, U>>> {
+    std::vector<std::vector<std::pair<U, U>>> res(threads);
+    forChunks(keys.size(), threads, [&keys, &res](unsigned t, size_t first, size_t last) {
+      auto& out = res[t];
+      for (auto i = first; i < last; ++i) {
+        if (!out.empty() && keys[i] - out.back().second <= 1) out.back().second = keys[i];
+        else out.emplace_back(keys[i], keys[i]);
+      }
+    });
+    return res;
+  }
+}
 
 namespace ranges = std::ranges;
 namespace views  = std::views;
 
+template<std::integral T>
+class IntegralSet;
+
+// Lazy set expressions. An expression is a tree of set operations whose
+// nodes produce the segments of their result in order, one at a time, by
+// pulling segments from their operands. Evaluating a chain of operations
+// is a single pass over all input segment lists, with no intermediate
+// sets. Expressions refer to the sets they were built from, which must
+// outlive them.
+namespace set_expr {
+
+  template<class E>
+  concept Expr = requires(E e, typename E::Segment& seg) {
+    typename E::value_type;
+    { e.next(seg) }         -> std::same_as<bool>;
+    { e.maxSegments() }     -> std::same_as<size_t>;
+  };
+
+  template<class Derived, std::integral T>
+  class ExprBase {
+  public:
+
+    using value_type = T;
+    using Segment    = std::pair<T, T>;
+
+    // Number of elements in the result, without materializing it.
+    auto size() const ->size_t {
+      using U = std::make_unsigned_t<T>;
+      auto    expr = derived_();
+      Segment seg;
+      size_t  res = 0;
+      while (expr.next(seg)) res += size_t(U(seg.second) - U(seg.first)) + 1;
+      return res;
+    }
+
+    auto empty() const ->bool {
+      auto    expr = derived_();
+      Segment seg;
+      return !expr.next(seg);
+    }
+
+    template<class Fn> requires std::invocable<Fn, T, T>
+    void forEachSegment(Fn fn) const {
+      auto    expr = derived_();
+      Segment seg;
+      while (expr.next(seg)) fn(seg.first, seg.second);
+    }
+
+    auto eval() const ->IntegralSet<T> {
+      return IntegralSet<T>(derived_());
+    }
+
+  private:
+
+    auto derived_() const ->Derived {
+      return static_cast<const Derived&>(*this);
+    }
+  };
+
+  // True if a segment starting at first would touch or overlap one ending
+  // at last, without overflowing at the ends of the value range.
+  template<std::integral T>
+  auto touches_(T last, T first) ->bool {
+    return first <= last || first - 1 == last;
+  }
+
+  template<std::integral T>
+  class Leaf: public ExprBase<Leaf<T>, T> {
+  public:
+
+    using Segment = std::pair<T, T>;
+
+    explicit Leaf(std::span<const Segment> segments): segments_(segments) {}
+
+    auto next(Segment& seg) ->bool {
+      if (pos_ == segments_.size()) return false;
+      seg = segments_[pos_++];
+      return true;
+    }
+
+    auto maxSegments() const ->size_t { return segments_.size(); }
+
+  private:
+
+    std::span<const Segment> segments_;
+    size_t                   pos_ = 0;
+  };
+
+  // Common state of binary nodes: both operands and their current heads.
+  template<class L, class R>
+  class Binary_ {
+  public:
+
+    using Segment = typename L::Segment;
+
+    Binary_(L l, R r): l_(std::move(l)), r_(std::move(r)) {}
+
+    auto maxSegments() const ->size_t { return l_.maxSegments() + r_.maxSegments(); }
+
+  protected:
+
+    void prime_() {
+      if (primed_) return;
+      lv_ = l_.next(lh_);
+      rv_ = r_.next(rh_);
+      primed_ = true;
+    }
+
+    L       l_;
+    R       r_;
+    Segment lh_{}, rh_{};
+    bool    lv_ = false, rv_ = false, primed_ = false;
+  };
+
+  template<Expr L, Expr R> requires std::same_as<typename L::value_type, typename R::value_type>
+  class Union: public ExprBase<Union<L, R>, typename L::value_type>, public Binary_<L, R> {
+  public:
+
+    using Segment = typename L::Segment;
+    using Binary_<L, R>::maxSegments;
+
+    Union(L l, R r): Binary_<L, R>(std::move(l), std::move(r)) {}
+
+    auto next(Segment& seg) ->bool {
+      this->prime_();
+      auto& lh = this->lh_;
+      auto& rh = this->rh_;
+      if (this->lv_ && (!this->rv_ || lh.first <= rh.first)) {
+        seg = lh;
+        this->lv_ = this->l_.next(lh);
+      } else if (this->rv_) {
+        seg = rh;
+        this->rv_ = this->r_.next(rh);
+      } else return false;
+      for (;;) {
+        if (this->lv_ && touches_(seg.second, lh.first)) {
+          if (lh.second > seg.second) seg.second = lh.second;
+          this->lv_ = this->l_.next(lh);
+        } else if (this->rv_ && touches_(seg.second, rh.first)) {
+          if (rh.second > seg.second) seg.second = rh.second;
+          this->rv_ = this->r_.next(rh);
+        } else return true;
+      }
+    }
+  };
+
+  template<Expr L, Expr R> requires std::same_as<typename L::value_type, typename R::value_type>
+  class Intersection: public ExprBase<Intersection<L, R>, typename L::value_type>, public Binary_<L, R> {
+  public:
+
+    using Segment = typename L::Segment;
+    using Binary_<L, R>::maxSegments;
+
+    Intersection(L l, R r): Binary_<L, R>(std::move(l), std::move(r)) {}
+
+    auto next(Segment& seg) ->bool {
+      this->prime_();
+      auto& lh = this->lh_;
+      auto& rh = this->rh_;
+      while (this->lv_ && this->rv_) {
+        auto first = lh.first  > rh.first?  lh.first  : rh.first;
+        auto last  = lh.second < rh.second? lh.second : rh.second;
+        if (lh.second < rh.second) this->lv_ = this->l_.next(lh);
+        else                       this->rv_ = this->r_.next(rh);
+        if (first <= last) {
+          seg = {first, last};
+          return true;
+        }
+      }
+      return false;
+    }
+  };
+
+  template<Expr L, Expr R> requires std::same_as<typename L::value_type, typename R::value_type>
+  class Difference: public ExprBase<Difference<L, R>, typename L::value_type>, public Binary_<L, R> {
+  public:
+
+    using Segment = typename L::Segment;
+    using Binary_<L, R>::maxSegments;
+
+    Difference(L l, R r): Binary_<L, R>(std::move(l), std::move(r)) {}
+
+    // lh_ holds what is left of the current segment of l_ after removing
+    // the segments of r_ seen so far.
+    auto next(Segment& seg) ->bool {
+      this->prime_();
+      auto& lh = this->lh_;
+      auto& rh = this->rh_;
+      while (this->lv_) {
+        while (this->rv_ && rh.second < lh.first) this->rv_ = this->r_.next(rh);
+        if (!this->rv_ || rh.first > lh.second) {
+          seg = lh;
+          this->lv_ = this->l_.next(lh);
+          return true;
+        }
+        bool emit = rh.first > lh.first;
+        if (emit) seg = {lh.first, rh.first - 1};
+        if (rh.second >= lh.second) this->lv_ = this->l_.next(lh);
+        else                        lh.first = rh.second + 1;
+        if (emit) return true;
+      }
+      return false;
+    }
+  };
+
+  template<class E>
+  concept Operand = Expr<E> || std::same_as<E, IntegralSet<typename E::value_type>>;
+
+  template<Operand E>
+  auto operand_(const E& e) {
+    if constexpr (Expr<E>) return e;
+    else return Leaf<typename E::value_type>(e.segments());
+  }
+
+  template<Operand L, Operand R> requires (Expr<L> || Expr<R>)
+  auto operator | (const L& l, const R& r) { return Union(operand_(l), operand_(r)); }
+
+  template<Operand L, Operand R> requires (Expr<L> || Expr<R>)
+  auto operator & (const L& l, const R& r) { return Intersection(operand_(l), operand_(r)); }
+
+  template<Operand L, Operand R> requires (Expr<L> || Expr<R>)
+  auto operator - (const L& l, const R& r) { return Difference(operand_(l), operand_(r)); }
+
+  // Expressions refer to the segments of the sets they are built from, so
+  // temporary sets would be gone before the expression is evaluated.
+  template<Expr L, std::integral T> void operator | (const L&, IntegralSet<T>&&) = delete;
+  template<std::integral T, Expr R> void operator | (IntegralSet<T>&&, const R&) = delete;
+  template<Expr L, std::integral T> void operator & (const L&, IntegralSet<T>&&) = delete;
+  template<std::integral T, Expr R> void operator & (IntegralSet<T>&&, const R&) = delete;
+  template<Expr L, std::integral T> void operator - (const L&, IntegralSet<T>&&) = delete;
+  template<std::integral T, Expr R> void operator - (IntegralSet<T>&&, const R&) = delete;
+}
+
 template<std::integral T>
 class IntegralSet {
 
+  // Sets of a few segments, such as an id pool handing out ids mostly in
+  // order, are stored inline without allocating.
+  static constexpr size_t inline_segments = 4;
+
+  using U                = std::make_unsigned_t<T>;
   using Segment          = std::pair<T, T>;
-  using SegmentVec       = std::vector<Segment>;
+  using SegmentVec       = SmallVector<Segment, inline_segments>;
   using SegmentIt        = SegmentVec::iterator;
   using ConstSegmentSpan = std::span<const Segment>;
 
@@ -28,14 +373,29 @@ class IntegralSet {
 
 public:
 
+  using value_type = T;
+
   IntegralSet() = default;
 
+  // Evaluates a set expression, allocating the result once.
+  template<set_expr::Expr E> requires std::same_as<typename E::value_type, T>
+  explicit IntegralSet(E expr) {
+    segments_.reserve(expr.maxSegments());
+    Segment seg;
+    while (expr.next(seg)) segments_.push_back(seg);
+  }
+
   IntegralSet(std::initializer_list<Segment> list) {
     mergeSegments_(views::all(list));
   }
-  IntegralSet(std::initializer_list<T> list) {
-    mergeValues_(views::all(list));
-  }
+  IntegralSet(std::initializer_list<T> list):
+    segments_(fromValues_(views::all(list), 1)) {}
+
+  // Builds the set from values in any order, sorting them in parallel.
+  template<ranges::input_range R>
+  requires std::convertible_to<ranges::range_reference_t<R>, T>
+  explicit IntegralSet(R&& values, unsigned threads = 0):
+    segments_(fromValues_(std::forward<R>(values), threads)) {}
 
   void insert(T val) {
     mergeValue_(val);
@@ -45,43 +405,51 @@ public:
     mergeSegmentsOrdered_(set.segments_);
   }
 
-  auto unite(const IntegralSet<T>& set) ->IntegralSet<T> {
-    if      (set.empty())             return *this;
-    else if (this->segments_.empty()) return set;
-    auto [set1, set2, first_seg] = pickHead_(this->segments_, set.segments_, std::less{});
-    SegmentVec merged;
-    auto proj = [](const auto& seg) { return seg.first; };
-    merged.push_back(first_seg);
-    ranges::merge(
-      set1, set2,
-      itertools::invoker([&merged](const Segment& seg) {
-        if (seg.first > merged.back().second + 1) merged.push_back(seg);
-        else if (seg.second > merged.back().second) merged.back().second = seg.second;
-      }),
-      {}, proj, proj
-    );
-    return IntegralSet<T>(std::move(merged));
-  }
-
-  auto intersect(const IntegralSet<T>& set) ->IntegralSet<T> {
-    if (this->segments_.empty() || set.empty()) return {};
-    auto [set1, set2, last_seg] = pickHead_(this->segments_, set.segments_, std::less{});
-    SegmentVec merged;
-    auto proj = [](const auto& seg) { return seg.first; };
-    ranges::merge(
-      set1, set2,
-      itertools::invoker([&merged, &last_seg](const Segment& seg) {
-        if (seg.first <= last_seg.second) merged.emplace_back(
-          seg.first,
-          seg.second < last_seg.second? seg.second : last_seg.second
-        );
-        if (seg.second > last_seg.second) last_seg = seg;
-      }),
-      {}, proj, proj
-    );
-    return IntegralSet<T>(std::move(merged));
+  // Merges values in any order, sorting them in parallel.
+  template<ranges::input_range R>
+  requires std::convertible_to<ranges::range_reference_t<R>, T>
+  void merge(R&& values, unsigned threads = 0) {
+    IntegralSet<T> set(std::forward<R>(values), threads);
+    if (segments_.empty()) segments_ = std::move(set.segments_);
+    else *this = IntegralSet<T>(*this | set);
+  }
+
+  auto unite(const IntegralSet<T>& set) const ->IntegralSet<T> {
+    return IntegralSet<T>(*this | set);
+  }
+
+  auto intersect(const IntegralSet<T>& set) const ->IntegralSet<T> {
+    return IntegralSet<T>(*this & set);
+  }
+
+  auto difference(const IntegralSet<T>& set) const ->IntegralSet<T> {
+    return IntegralSet<T>(*this - set);
   }
 
+  friend auto operator | (const IntegralSet<T>& a, const IntegralSet<T>& b) {
+    return set_expr::Union(set_expr::Leaf<T>(a.segments_), set_expr::Leaf<T>(b.segments_));
+  }
+
+  friend auto operator & (const IntegralSet<T>& a, const IntegralSet<T>& b) {
+    return set_expr::Intersection(set_expr::Leaf<T>(a.segments_), set_expr::Leaf<T>(b.segments_));
+  }
+
+  friend auto operator - (const IntegralSet<T>& a, const IntegralSet<T>& b) {
+    return set_expr::Difference(set_expr::Leaf<T>(a.segments_), set_expr::Leaf<T>(b.segments_));
+  }
+
+  // The operators return expressions referring to their operands, which
+  // must not be temporaries.
+  friend void operator | (IntegralSet<T>&&, const IntegralSet<T>&) = delete;
+  friend void operator | (const IntegralSet<T>&, IntegralSet<T>&&) = delete;
+  friend void operator | (IntegralSet<T>&&, IntegralSet<T>&&) = delete;
+  friend void operator & (IntegralSet<T>&&, const IntegralSet<T>&) = delete;
+  friend void operator & (const IntegralSet<T>&, IntegralSet<T>&&) = delete;
+  friend void operator & (IntegralSet<T>&&, IntegralSet<T>&&) = delete;
+  friend void operator - (IntegralSet<T>&&, const IntegralSet<T>&) = delete;
+  friend void operator - (const IntegralSet<T>&, IntegralSet<T>&&) = delete;
+  friend void operator - (IntegralSet<T>&&, IntegralSet<T>&&) = delete;
+
   auto takeHead() ->T {
     if (segments_.size() == 0) throw std::out_of_range("IntegralSet::takeHead: no elements");
     auto& seg = segments_[0];
@@ -93,6 +461,12 @@ public:
 
   auto takeHead(size_t n) ->IntegralSet<T> {
     if (n == 0) return IntegralSet<T>{};
+    if (!segments_.empty() && size_t(U(segments_[0].second) - U(segments_[0].first)) >= n) {
+      SegmentVec res;
+      res.emplace_back(segments_[0].first, T(segments_[0].first + T(n - 1)));
+      segments_[0].first = T(res[0].second + 1);
+      return IntegralSet<T>(std::move(res));
+    }
     auto split = split_(segments_.begin(), segments_.end(), n);
 
     SegmentVec res;
@@ -152,7 +526,7 @@ public:
 
   auto size() const ->size_t {
     size_t res = 0;
-    for (const auto& seg: segments_) res += (seg.second + 1) - seg.first;
+    for (const auto& seg: segments_) res += size_t(U(seg.second) - U(seg.first)) + 1;
     return res;
   }
 
@@ -169,11 +543,61 @@ public:
     return it != segments_.end() && it->first <= val;
   }
 
+  auto segments() const ->ConstSegmentSpan {
+    return segments_;
+  }
+
+  template<class Fn> requires std::invocable<Fn, T>
+  void forEach(Fn fn) const {
+    for (const auto& seg: segments_) {
+      for (T val = seg.first;; ++val) {
+        fn(val);
+        if (val == seg.second) break;
+      }
+    }
+  }
+
   bool operator == (const IntegralSet<T>&) const = default;
 
+  // Appends the set to buf in a compact binary format: the number of
+  // segments and of elements, followed by each segment as the gap from the
+  // previous one and its length, all as varints.
+  void encode(std::vector<char>& buf) const {
+    namespace codec = integral_set_codec;
+    codec::putVarint(buf, segments_.size());
+    codec::putVarint(buf, size());
+    for (size_t i = 0; i < segments_.size(); ++i) {
+      auto first = codec::key(segments_[i].first);
+      auto last  = codec::key(segments_[i].second);
+      codec::putVarint(buf, i == 0? first : first - codec::key(segments_[i - 1].second) - 2);
+      codec::putVarint(buf, last - first);
+    }
+  }
+
+  // Decodes a set encoded at the start of buf. If consumed is given, the
+  // number of bytes read is stored in it.
+  static auto decode(std::span<const char> buf, size_t* consumed = nullptr) ->IntegralSet<T> {
+    namespace codec = integral_set_codec;
+    const char* pos = buf.data();
+    const char* end = pos + buf.size();
+    auto num = codec::getVarint(pos, end);
+    codec::getVarint(pos, end);
+    if (num > buf.size()) throw std::invalid_argument("IntegralSet::decode: truncated input");
+    IntegralSet<T> set;
+    set.segments_.reserve(num);
+    U last = 0;
+    for (uint64_t i = 0; i < num; ++i) {
+      U first = i == 0? U(codec::getVarint(pos, end)) : U(last + 2 + codec::getVarint(pos, end));
+      last = first + U(codec::getVarint(pos, end));
+      set.segments_.emplace_back(codec::value<T>(first), codec::value<T>(last));
+    }
+    if (consumed != nullptr) *consumed = pos - buf.data();
+    return set;
+  }
+
 private:
 
-  IntegralSet(SegmentVec&& segments): segments_(segments) {}
+  IntegralSet(SegmentVec&& segments): segments_(std::move(segments)) {}
 
   template<ranges::input_range R> requires std::same_as<ranges::range_value_t<R>, Segment>
   void mergeSegments_(R segments) {
@@ -224,14 +648,44 @@ private:
     return std::next(segments_.begin(), dist);
   }
 
-  template<ranges::input_range R> requires std::same_as<ranges::range_value_t<R>, T>
-  void mergeValues_(R values) {
-    for (const auto val: values) {
-      mergeValue_(val);
+  template<ranges::input_range R>
+  static auto fromValues_(R&& values, unsigned threads) ->SegmentVec {
+    namespace bulk = integral_set_bulk;
+    std::vector<U> keys;
+    if constexpr (ranges::sized_range<R>) keys.reserve(ranges::size(values));
+    for (auto&& val: values) keys.push_back(integral_set_codec::key(T(val)));
+    threads = numChunks(keys.size(), threads, bulk::min_values_per_thread);
+    bulk::radixSort(keys, threads);
+
+    auto runs = bulk::runs(keys, threads);
+    size_t num_runs = 0;
+    for (const auto& chunk: runs) num_runs += chunk.size();
+    SegmentVec res;
+    res.reserve(num_runs);
+    for (const auto& chunk: runs) {
+      for (auto [first, last]: chunk) {
+        if (!res.empty() && first - integral_set_codec::key(res.back().second) <= 1)
+          res.back().second = integral_set_codec::value<T>(last);
+        else
+          res.emplace_back(integral_set_codec::value<T>(first), integral_set_codec::value<T>(last));
+      }
     }
+    return res;
   }
 
+  // Values freed just below the first or above the last segment, as when
+  // returning recently allocated ids, skip the search.
   void mergeValue_(T val) {
+    if (!segments_.empty() && val < segments_.front().first) {
+      if (val + 1 == segments_.front().first) segments_.front().first = val;
+      else segments_.emplace(segments_.begin(), val, val);
+      return;
+    }
+    if (!segments_.empty() && val > segments_.back().second) {
+      if (val - 1 == segments_.back().second) segments_.back().second = val;
+      else segments_.emplace_back(val, val);
+      return;
+    }
     auto bit = ranges::lower_bound(
       segments_,
       val,
@@ -284,30 +738,6 @@ private:
     };
   }
 
-  template<class Comp>
-  requires std::same_as<
-    typename std::invoke_result<Comp, const Segment&, const Segment&>::type,
-    bool>
-  auto pickHead_(
-    const SegmentVec& vec1,
-    const SegmentVec& vec2,
-    Comp comp
-  ) ->std::tuple<ConstSegmentSpan, ConstSegmentSpan, Segment> {
-    if (!vec1.empty() && (vec2.empty() || comp(vec1.front(), vec2.front()))) {
-      return std::make_tuple(
-        std::span(vec1.begin() + 1, vec1.end()),
-        std::span(vec2),
-        vec1.front()
-      );
-    } else {
-      return std::make_tuple(
-        std::span(vec1),
-        std::span(vec2.begin() + 1, vec2.end()),
-        vec2.front()
-      );
-    }
-  }
-
   template<class Y>
   friend std::ostream& operator << (std::ostream&, const IntegralSet<Y>&);
 };
@@ -315,15 +745,71 @@ private:
 template<class T>
 std::ostream& operator << (std::ostream& os, const IntegralSet<T>& set) {
   os << '{';
-  if (!set.segments_.empty()) {
-    auto subsets = set.segments_ | views::transform([](const auto& seg) {
-      return std::format("{}..{}", seg.first, seg.second);
-    });
-    os << *subsets.begin();
-    for (const auto& ss: subsets | views::drop(1)) os << ", " << ss;
+  for (size_t i = 0; i < set.segments_.size(); ++i) {
+    if (i > 0) os << ", ";
+    os << set.segments_[i].first << ".." << set.segments_[i].second;
   }
   os << '}';
   return os;
 }
 
+// Read-only view of an encoded IntegralSet, answering queries directly on
+// the encoded bytes.
+template<std::integral T>
+class EncodedIntegralSet {
+public:
+
+  EncodedIntegralSet(std::span<const char> buf): buf_(buf) {
+    const char* pos = buf_.data();
+    num_segments_ = integral_set_codec::getVarint(pos, buf_.data() + buf_.size());
+    size_         = integral_set_codec::getVarint(pos, buf_.data() + buf_.size());
+    body_         = pos;
+  }
+
+  auto size() const ->size_t          { return size_; }
+  auto empty() const ->bool           { return num_segments_ == 0; }
+  auto numSegments() const ->size_t   { return num_segments_; }
+
+  template<class Fn> requires std::invocable<Fn, T, T>
+  void forEachSegment(Fn fn) const {
+    scan_([&fn](T first, T last) { fn(first, last); return true; });
+  }
+
+  auto contains(T val) const ->bool {
+    bool found = false;
+    scan_([&found, val](T first, T last) {
+      if (val < first) return false;
+      found = val <= last;
+      return !found;
+    });
+    return found;
+  }
+
+  auto decode() const ->IntegralSet<T> {
+    return IntegralSet<T>::decode(buf_);
+  }
+
+private:
+
+  // Calls fn on the segments in order until it returns false.
+  template<class Fn>
+  void scan_(Fn fn) const {
+    namespace codec = integral_set_codec;
+    using U = std::make_unsigned_t<T>;
+    const char* pos = body_;
+    const char* end = buf_.data() + buf_.size();
+    U last = 0;
+    for (size_t i = 0; i < num_segments_; ++i) {
+      U first = i == 0? U(codec::getVarint(pos, end)) : U(last + 2 + codec::getVarint(pos, end));
+      last = first + U(codec::getVarint(pos, end));
+      if (!fn(codec::value<T>(first), codec::value<T>(last))) return;
+    }
+  }
+
+  std::span<const char> buf_;
+  const char*           body_;
+  size_t                num_segments_;
+  size_t                size_;
+};
+
 #endif // integral_set_hpp_INCLUDED
@@ -2,6 +2,9 @@
 
 #include <catch2/catch_test_macros.hpp>
 
+#include <limits>
+#include <vector>
+
 TEST_CASE("IntegralSet: construction by segments", "[IntegralSet]") {
   SECTION("segment order") {
     REQUIRE(
@@ -70,6 +73,33 @@ TEST_CASE("IntegralSet: construction by elements", "[IntegralSet]") {
   }
 }
 
+TEST_CASE("IntegralSet: construction from a range", "[IntegralSet]") {
+  SECTION("small") {
+    REQUIRE(IntegralSet<int>(std::vector<int>{}) == IntegralSet<int>{});
+    REQUIRE(IntegralSet<int>(std::vector<int>{9, -3, 4, -2, 5, 9, -1, 3}) == IntegralSet<int>{{-3, -1}, {3, 5}, {9, 9}});
+  }
+  SECTION("large, in parallel") {
+    std::vector<uint64_t> ids;
+    for (uint64_t id = 0; id < 300000; ++id) if (id % 1000 != 7) ids.push_back(id * 7919 % 300000 + (uint64_t(1) << 40));
+    for (unsigned threads: {1u, 4u}) {
+      IntegralSet<uint64_t> set(ids, threads);
+      REQUIRE(set.size() == ids.size());
+      REQUIRE(set.segments().size() == 301);
+      REQUIRE(set.segments().front().first == uint64_t(1) << 40);
+      for (auto id: {uint64_t(7), uint64_t(1007), uint64_t(299007)})
+        REQUIRE(!set.contains((id * 7919 % 300000) + (uint64_t(1) << 40)));
+    }
+  }
+  SECTION("merge") {
+    IntegralSet<int> set{{0, 9}, {20, 29}};
+    set.merge(std::vector<int>{15, 10, 11, 19, 40, 12});
+    REQUIRE(set == IntegralSet<int>{{0, 12}, {15, 15}, {19, 29}, {40, 40}});
+    IntegralSet<int> empty;
+    empty.merge(std::views::iota(5, 10));
+    REQUIRE(empty == IntegralSet<int>{{5, 9}});
+  }
+}
+
 TEST_CASE("IntegralSet::insert", "[IntegralSet]") {
   IntegralSet<int> set;
 
@@ -176,6 +206,110 @@ TEST_CASE("IntegralSet::intersect", "[IntegralSet]") {
   }
 }
 
+TEST_CASE("IntegralSet::difference", "[IntegralSet]") {
+  SECTION("no overlap") {
+    REQUIRE(
+      IntegralSet<int>{1, 4, 7}.difference(
+        IntegralSet<int>{{2, 3}, {5, 6}}
+      ) == IntegralSet<int>{1, 4, 7}
+    );
+  }
+  SECTION("split segments") {
+    REQUIRE(
+      IntegralSet<int>{{1, 10}, {14, 20}}.difference(
+        IntegralSet<int>{{0, 2}, {5, 5}, {8, 15}, {20, 22}}
+      ) == IntegralSet<int>{{3, 4}, {6, 7}, {16, 19}}
+    );
+  }
+  SECTION("remove everything") {
+    REQUIRE(IntegralSet<int>{{1, 5}}.difference(IntegralSet<int>{{0, 9}}) == IntegralSet<int>{});
+  }
+}
+
+namespace {
+  template<class A, class B>
+  concept Unitable_ = requires(A&& a, B&& b) { std::forward<A>(a) | std::forward<B>(b); };
+}
+
+TEST_CASE("IntegralSet: set expressions", "[IntegralSet]") {
+  SECTION("chained operations") {
+    IntegralSet<int> a{{0, 9}, {20, 29}}, b{{5, 24}}, c{{40, 45}}, d{{8, 21}, {43, 50}};
+
+    auto expr = ((a & b) | c) - d;
+    REQUIRE(expr.size() == 9);
+    REQUIRE(!expr.empty());
+    REQUIRE(expr.eval() == IntegralSet<int>{{5, 7}, {22, 24}, {40, 42}});
+    REQUIRE((a & c).empty());
+    REQUIRE((a & c).size() == 0);
+  }
+  SECTION("value range ends") {
+    constexpr auto min = std::numeric_limits<int>::min(), max = std::numeric_limits<int>::max();
+    IntegralSet<int> a{{min, -1}}, b{{0, max}}, top{max};
+    REQUIRE(IntegralSet<int>(a | b) == IntegralSet<int>{{min, max}});
+    REQUIRE(IntegralSet<int>(b - top) == IntegralSet<int>{{0, max - 1}});
+  }
+  SECTION("no temporary operands") {
+    using Set = IntegralSet<int>;
+    STATIC_REQUIRE(Unitable_<const Set&, const Set&>);
+    STATIC_REQUIRE(!Unitable_<Set, const Set&>);
+    STATIC_REQUIRE(!Unitable_<const Set&, Set>);
+    using Expr = decltype(std::declval<const Set&>() | std::declval<const Set&>());
+    STATIC_REQUIRE(Unitable_<Expr, const Set&>);
+    STATIC_REQUIRE(!Unitable_<Expr, Set>);
+    STATIC_REQUIRE(!Unitable_<Set, Expr>);
+  }
+  SECTION("matches element-wise evaluation") {
+    uint32_t state = 1;
+    auto random_set = [&state]() {
+      IntegralSet<int> set;
+      for (int val = 0; val < 64; ++val) {
+        state = state * 1664525 + 1013904223;
+        if (state >> 31) set.insert(val);
+      }
+      return set;
+    };
+    for (int round = 0; round < 20; ++round) {
+      auto a = random_set(), b = random_set(), c = random_set();
+      IntegralSet<int> res((a - b) | (b & c));
+      for (int val = 0; val < 64; ++val) {
+        bool expected = (a.contains(val) && !b.contains(val)) || (b.contains(val) && c.contains(val));
+        REQUIRE(res.contains(val) == expected);
+      }
+      REQUIRE(((a - b) | (b & c)).size() == res.size());
+    }
+  }
+}
+
+TEST_CASE("IntegralSet: storage", "[IntegralSet]") {
+  SECTION("moves do not throw") {
+    STATIC_REQUIRE(std::is_nothrow_move_constructible_v<IntegralSet<int>>);
+    STATIC_REQUIRE(std::is_nothrow_move_assignable_v<IntegralSet<int>>);
+  }
+  SECTION("growing past the inline segments") {
+    IntegralSet<int> set;
+    for (int val = 20; val >= 0; val -= 2) set.insert(val);
+    for (int val = 21; val < 40; val += 2) set.insert(val);
+    REQUIRE(set.segments().size() == 20);
+    IntegralSet<int> copy = set;
+    IntegralSet<int> moved = std::move(set);
+    REQUIRE(copy == moved);
+    REQUIRE(moved.size() == 21);
+    for (int val = 1; val < 20; val += 2) moved.insert(val);
+    REQUIRE(moved == IntegralSet<int>{{0, 21}, {23, 23}, {25, 25}, {27, 27}, {29, 29}, {31, 31}, {33, 33}, {35, 35}, {37, 37}, {39, 39}});
+  }
+  SECTION("id pool") {
+    IntegralSet<uint64_t> pool{{1, 1000}};
+    auto a = pool.takeHead(), b = pool.takeHead();
+    auto batch = pool.takeHead(10);
+    REQUIRE(batch == IntegralSet<uint64_t>{{3, 12}});
+    pool.insert(b);
+    REQUIRE(pool == IntegralSet<uint64_t>{{2, 2}, {13, 1000}});
+    pool.insert(a);
+    pool.merge(batch);
+    REQUIRE(pool == IntegralSet<uint64_t>{{1, 1000}});
+  }
+}
+
 TEST_CASE("IntegralSet::takeHead", "[IntegralSet]") {
   IntegralSet<int> set = {{1, 2}, {4, 5}, {7, 8}};
 
@@ -296,3 +430,54 @@ TEST_CASE("IntegralSet::contains", "[IntegralSet]") {
   REQUIRE(!set.contains(4));
   REQUIRE(!set.contains(8));
 }
+
+TEST_CASE("IntegralSet::forEach", "[IntegralSet]") {
+  std::vector<int> elems;
+  IntegralSet<int>{{1, 2}, {4, 4}, {6, 8}}.forEach([&elems](int val) { elems.push_back(val); });
+  REQUIRE(elems == std::vector<int>{1, 2, 4, 6, 7, 8});
+}
+
+TEST_CASE("IntegralSet: encoding", "[IntegralSet]") {
+  SECTION("round trip") {
+    for (const auto& set: {
+      IntegralSet<int>{},
+      IntegralSet<int>{{-100, -50}, {-3, 4}, {7, 7}, {1000000, 2000000}},
+      IntegralSet<int>{{std::numeric_limits<int>::min(), std::numeric_limits<int>::max() - 2}},
+    }) {
+      std::vector<char> buf;
+      set.encode(buf);
+      size_t consumed = 0;
+      REQUIRE(IntegralSet<int>::decode(buf, &consumed) == set);
+      REQUIRE(consumed == buf.size());
+    }
+  }
+  SECTION("size") {
+    IntegralSet<uint64_t> set{{1, 1'000'000'000'000}, {1'000'000'000'002, 1'000'000'000'010}};
+    std::vector<char> buf;
+    set.encode(buf);
+    REQUIRE(buf.size() == 2 + 6 + 6 + 1 + 1);
+  }
+  SECTION("truncated input") {
+    std::vector<char> buf;
+    IntegralSet<int>{1, 3, 5}.encode(buf);
+    buf.pop_back();
+    REQUIRE_THROWS_AS(IntegralSet<int>::decode(buf), std::invalid_argument);
+  }
+}
+
+TEST_CASE("EncodedIntegralSet", "[IntegralSet]") {
+  IntegralSet<int> set{{-5, -3}, {1, 2}, {8, 8}};
+  std::vector<char> buf;
+  set.encode(buf);
+  EncodedIntegralSet<int> view(buf);
+
+  REQUIRE(view.size() == 6);
+  REQUIRE(view.numSegments() == 3);
+  REQUIRE(!view.empty());
+  for (int val = -7; val < 10; ++val) REQUIRE(view.contains(val) == set.contains(val));
+  REQUIRE(view.decode() == set);
+
+  std::vector<std::pair<int, int>> segments;
+  view.forEachSegment([&segments](int first, int last) { segments.emplace_back(first, last); });
+  REQUIRE(segments == std::vector<std::pair<int, int>>{{-5, -3}, {1, 2}, {8, 8}});
+}
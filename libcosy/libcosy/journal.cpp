@@ -0,0 +1,263 @@
+#include <libcosy/journal.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+  constexpr char magic_[8] = {'c', 'o', 's', 'y', 'j', 'n', 'l', '1'};
+
+  enum Kind_: char {
+    spawn_    = 1,
+    despawn_  = 2,
+    inject_   = 3,
+    snapshot_ = 4,
+    end_tick_ = 5,
+  };
+
+  void writeAll_(int fd, const char* data, size_t size) {
+    while (size > 0) {
+      auto res = ::write(fd, data, size);
+      if (res < 0) {
+        if (errno == EINTR) continue;
+        throw std::system_error(errno, std::generic_category(), "journal write");
+      }
+      data += res;
+      size -= res;
+    }
+  }
+
+  void applyInjection_(Table& table, const Attribute& attr, const ActorSet& ids, const char* values) {
+    size_t size = attr.type->size();
+    ids.forEach([&](ActorId id) {
+      if (attr.cold)                 table.cold(attr).set(table.slot(id), values);
+      else if (attr.column)          table.setColumnValue(attr, table.slot(id), values);
+      else if (attr.double_buffered) std::memcpy(table.bufferedRecord(id) + attr.offset, values, size);
+      else                           std::memcpy(table.record(id) + attr.offset, values, size);
+      values += size;
+    });
+    if (attr.cold) table.cold(attr).flush();
+  }
+}
+
+JournalWriter::JournalWriter(Table& table, const std::string& path, size_t buffer_size):
+  table_(table),
+  fd_(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)),
+  buffer_size_(buffer_size) {
+  if (fd_ < 0) throw std::system_error(errno, std::generic_category(), std::format("open {}", path));
+  buffer_.reserve(buffer_size_);
+  buffer_.insert(buffer_.end(), std::begin(magic_), std::end(magic_));
+  snapshot();
+  writer_ = std::thread([this] { writeLoop_(); });
+}
+
+JournalWriter::~JournalWriter() {
+  {
+    std::unique_lock lock(mutex_);
+    if (!buffer_.empty()) queue_.push_back(std::move(buffer_));
+    done_ = true;
+  }
+  cv_.notify_all();
+  writer_.join();
+  ::close(fd_);
+}
+
+auto JournalWriter::spawn(int n) ->ActorSet {
+  auto ids = table_.newActors(n);
+  payload_.clear();
+  ids.encode(payload_);
+  entry_(spawn_, payload_);
+  return ids;
+}
+
+void JournalWriter::despawn(const ActorSet& ids) {
+  table_.deleteActors(ids);
+  payload_.clear();
+  ids.encode(payload_);
+  entry_(despawn_, payload_);
+}
+
+void JournalWriter::inject(const Attribute& attr, const ActorSet& ids, std::span<const char> values) {
+  if (values.size() != ids.size() * attr.type->size())
+    throw std::invalid_argument(std::format("expected one value of attribute '{}' per actor", attr.name));
+  ids.forEach([this](ActorId id) {
+    if (!table_.contains(id)) throw std::invalid_argument(std::format("actor {} is not in the table", id));
+  });
+  applyInjection_(table_, attr, ids, values.data());
+  payload_.clear();
+  integral_set_codec::putVarint(payload_, attr.name.size());
+  payload_.insert(payload_.end(), attr.name.begin(), attr.name.end());
+  ids.encode(payload_);
+  payload_.insert(payload_.end(), values.begin(), values.end());
+  entry_(inject_, payload_);
+}
+
+void JournalWriter::snapshot() {
+  if (tick_has_inputs_) throw std::logic_error("snapshots must be taken before the inputs of a tick");
+  payload_.clear();
+  table_.saveState(payload_);
+  entry_(snapshot_, payload_);
+  tick_has_inputs_ = false;
+}
+
+void JournalWriter::endTick() {
+  payload_.clear();
+  entry_(end_tick_, payload_);
+  ++tick_;
+  tick_has_inputs_ = false;
+  if (buffer_.size() >= buffer_size_) submit_();
+}
+
+auto JournalWriter::tick() const ->uint64_t {
+  return tick_;
+}
+
+void JournalWriter::flush() {
+  submit_();
+  std::unique_lock lock(mutex_);
+  cv_.wait(lock, [this] { return (queue_.empty() && !writing_) || error_; });
+  if (error_) std::rethrow_exception(error_);
+}
+
+void JournalWriter::entry_(char kind, const std::vector<char>& payload) {
+  buffer_.push_back(kind);
+  integral_set_codec::putVarint(buffer_, payload.size());
+  buffer_.insert(buffer_.end(), payload.begin(), payload.end());
+  tick_has_inputs_ = true;
+}
+
+// At most max_queued buffers wait for the writer thread, which bounds the
+// memory used when the disk cannot keep up.
+void JournalWriter::submit_() {
+  std::unique_lock lock(mutex_);
+  cv_.wait(lock, [this] { return queue_.size() < max_queued || error_; });
+  if (error_) std::rethrow_exception(error_);
+  if (buffer_.empty()) return;
+  queue_.push_back(std::move(buffer_));
+  buffer_ = {};
+  buffer_.reserve(buffer_size_);
+  lock.unlock();
+  cv_.notify_all();
+}
+
+void JournalWriter::writeLoop_() {
+  std::unique_lock lock(mutex_);
+  for (;;) {
+    cv_.wait(lock, [this] { return !queue_.empty() || done_; });
+    if (queue_.empty()) return;
+    auto buf = std::move(queue_.front());
+    queue_.pop_front();
+    writing_ = true;
+    lock.unlock();
+    std::exception_ptr error;
+    try {
+      writeAll_(fd_, buf.data(), buf.size());
+    } catch (...) {
+      error = std::current_exception();
+    }
+    lock.lock();
+    writing_ = false;
+    if (error && !error_) error_ = error;
+    cv_.notify_all();
+  }
+}
+
+JournalReplay::JournalReplay(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) throw std::runtime_error(std::format("cannot open journal {}", path));
+  data_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  if (data_.size() < sizeof(magic_) || !std::equal(std::begin(magic_), std::end(magic_), data_.begin()))
+    throw std::runtime_error(std::format("{} is not a journal", path));
+
+  // Inputs of an incomplete last tick are dropped.
+  const char* pos = data_.data() + sizeof(magic_);
+  const char* end = data_.data() + data_.size();
+  size_t complete = 0;
+  while (pos < end) {
+    auto kind = *pos++;
+    uint64_t size;
+    try {
+      size = integral_set_codec::getVarint(pos, end);
+    } catch (const std::invalid_argument&) {
+      break;
+    }
+    if (size > size_t(end - pos)) break;
+    if (kind == snapshot_) snapshots_.emplace_back(num_ticks_, entries_.size());
+    entries_.push_back(Entry_{.kind = kind, .pos = size_t(pos - data_.data()), .size = size});
+    pos += size;
+    if (kind == end_tick_) ++num_ticks_;
+    if (kind == end_tick_ || kind == snapshot_) complete = entries_.size();
+  }
+  entries_.resize(complete);
+  std::erase_if(snapshots_, [complete](const auto& snapshot) { return snapshot.second >= complete; });
+}
+
+auto JournalReplay::numTicks() const ->uint64_t {
+  return num_ticks_;
+}
+
+auto JournalReplay::snapshotTicks() const ->std::vector<uint64_t> {
+  std::vector<uint64_t> res;
+  for (const auto& snapshot: snapshots_) res.push_back(snapshot.first);
+  return res;
+}
+
+auto JournalReplay::run(Table& table, uint64_t first, uint64_t last, const Step& step) const ->uint64_t {
+  if (first > last || last > num_ticks_) throw std::out_of_range("tick window out of range");
+  auto it = std::upper_bound(snapshots_.begin(), snapshots_.end(), first, [](uint64_t tick, const auto& snapshot) {
+    return tick < snapshot.first;
+  });
+  if (it == snapshots_.begin()) throw std::runtime_error("journal has no snapshot before the window");
+  auto [start, snapshot] = *std::prev(it);
+  table.loadState(std::span(data_.data() + entries_[snapshot].pos, entries_[snapshot].size));
+
+  auto tick = start;
+  for (auto idx = snapshot + 1; idx < entries_.size() && tick < last; ++idx) {
+    const auto& entry = entries_[idx];
+    auto payload = std::span(data_.data() + entry.pos, entry.size);
+    switch (entry.kind) {
+    case spawn_: {
+      auto expected = ActorSet::decode(payload);
+      if (table.newActors(expected.size()) != expected)
+        throw std::runtime_error(std::format("journal replay diverged at tick {}", tick));
+      break;
+    }
+    case despawn_:
+      table.deleteActors(ActorSet::decode(payload));
+      break;
+    case inject_: {
+      const char* pos = payload.data();
+      const char* end = pos + payload.size();
+      auto len = integral_set_codec::getVarint(pos, end);
+      if (len > size_t(end - pos)) throw std::runtime_error("corrupt journal entry");
+      std::string name(pos, len);
+      pos += len;
+      auto attr = table.type()->attribute(name);
+      if (attr == nullptr) throw std::runtime_error(std::format("journal refers to unknown attribute '{}'", name));
+      size_t consumed;
+      auto ids = ActorSet::decode(std::span(pos, end), &consumed);
+      pos += consumed;
+      if (size_t(end - pos) != ids.size() * attr->type->size()) throw std::runtime_error("corrupt journal entry");
+      applyInjection_(table, *attr, ids, pos);
+      break;
+    }
+    case snapshot_:
+      break;
+    case end_tick_:
+      if (step) step(tick);
+      ++tick;
+      break;
+    default:
+      throw std::runtime_error("corrupt journal entry");
+    }
+  }
+  return start;
+}
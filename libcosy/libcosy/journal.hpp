@@ -0,0 +1,124 @@
+#ifndef journal_hpp_INCLUDED
+#define journal_hpp_INCLUDED
+
+#include <libcosy/table.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Input journals record the inputs applied to a table from outside the
+// simulation, tick by tick: spawns, despawns and attribute writes. Replaying
+// a journal reproduces a run without repeating its setup, and the snapshots
+// it contains let a replay start close to any tick.
+//
+// A journal file is a header followed by entries, each a kind byte, the
+// payload size as a varint and the payload. Ids are stored as encoded
+// ActorSets and table snapshots as written by Table::saveState.
+
+// Applies inputs to a table and records them. Entries are collected in
+// memory and written out by a background thread, so recording does not
+// block the simulation on I/O.
+class JournalWriter {
+public:
+
+  // Creates or truncates the journal at path and records the initial state
+  // of the table. Buffers are handed to the writer thread once they hold
+  // buffer_size bytes.
+  JournalWriter(Table& table, const std::string& path, size_t buffer_size = 1 << 20);
+  ~JournalWriter();
+
+  JournalWriter(const JournalWriter&) = delete;
+  auto operator = (const JournalWriter&) ->JournalWriter& = delete;
+
+  auto spawn(int n) ->ActorSet;
+  void despawn(const ActorSet& ids);
+
+  // Writes a value of attr to each actor in ids. values holds one value
+  // per actor, in id order. Double-buffered attributes are written to
+  // their current state.
+  void inject(const Attribute& attr, const ActorSet& ids, std::span<const char> values);
+
+  // Records the state of the table, so that replays can start at the
+  // current tick. Must be called before any input of the tick.
+  void snapshot();
+
+  void endTick();
+
+  // The number of completed ticks.
+  auto tick() const ->uint64_t;
+
+  // Blocks until everything recorded so far is written. Rethrows errors
+  // of the writer thread.
+  void flush();
+
+private:
+
+  void entry_(char kind, const std::vector<char>& payload);
+  void submit_();
+  void writeLoop_();
+
+  static constexpr size_t max_queued = 4;
+
+  Table&                        table_;
+  int                           fd_;
+  size_t                        buffer_size_;
+  uint64_t                      tick_ = 0;
+  bool                          tick_has_inputs_ = false;
+  std::vector<char>             buffer_;
+  std::vector<char>             payload_;
+
+  std::mutex                    mutex_;
+  std::condition_variable       cv_;
+  std::deque<std::vector<char>> queue_;
+  bool                          writing_ = false;
+  bool                          done_    = false;
+  std::exception_ptr            error_;
+  std::thread                   writer_;
+};
+
+// Replays a journal onto a table. The journal is read into memory and
+// indexed by tick when opened. A journal cut short, e.g. by a crash, is
+// replayable up to its last complete tick.
+class JournalReplay {
+public:
+
+  using Step = std::function<void(uint64_t tick)>;
+
+  JournalReplay(const std::string& path);
+
+  // The number of complete ticks in the journal.
+  auto numTicks() const ->uint64_t;
+
+  // The ticks at which a snapshot was recorded.
+  auto snapshotTicks() const ->std::vector<uint64_t>;
+
+  // Replays the journal onto table, which must be empty and of the type
+  // the journal was recorded with, until tick last. The table is restored
+  // from the latest snapshot at or before tick first, and the inputs of
+  // each tick from there on are applied, followed by a call to step to run
+  // the simulation for the tick. Returns the tick the replay started at.
+  // Throws std::runtime_error if the replay diverges from the recording.
+  auto run(Table& table, uint64_t first, uint64_t last, const Step& step = {}) const ->uint64_t;
+
+private:
+
+  struct Entry_ {
+    char   kind;
+    size_t pos,
+           size;
+  };
+
+  std::vector<char>                        data_;
+  std::vector<Entry_>                      entries_;
+  uint64_t                                 num_ticks_ = 0;
+  std::vector<std::pair<uint64_t, size_t>> snapshots_; // tick and entry
+};
+
+#endif // journal_hpp_INCLUDED
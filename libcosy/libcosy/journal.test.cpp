@@ -0,0 +1,91 @@
+#include <libcosy/mock/attribute_type.hpp>
+#include <libcosy/journal.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <format>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace {
+  // The simulation: every tick adds the current tick to each value.
+  void step_(Table& table, const Attribute& attr, uint64_t tick) {
+    auto field = table.field(attr);
+    for (uint64_t slot = 0; slot < table.numActors(); ++slot)
+      field.set<uint32_t>(slot, field.get<uint32_t>(slot) + uint32_t(tick));
+  }
+
+  auto state_(const Table& table) ->std::vector<char> {
+    std::vector<char> buf;
+    table.saveState(buf);
+    return buf;
+  }
+}
+
+TEST_CASE("Journal", "[Journal]") {
+  AttributeTypeMock atm {"type mock", 4, 4};
+  ActorType type("actor", RecordType{
+    Attribute{.name = "val", .type = &atm},
+    Attribute{.name = "state", .type = &atm, .double_buffered = true},
+    Attribute{.name = "tag", .type = &atm, .cold = true},
+  });
+  auto& val   = *type.attribute("val");
+  auto& state = *type.attribute("state");
+  auto& tag   = *type.attribute("tag");
+  auto path = (std::filesystem::temp_directory_path() / std::format("cosy-journal-{}", getpid())).string();
+
+  Table table(&type);
+  table.newActors(3); // setup before recording
+  std::vector<std::vector<char>> states;
+  {
+    JournalWriter journal(table, path, 64);
+    for (uint64_t tick = 0; tick < 6; ++tick) {
+      if (tick == 3) journal.snapshot();
+      auto ids = journal.spawn(2);
+      std::vector<uint32_t> vals{uint32_t(tick), uint32_t(tick * 10)};
+      auto bytes = std::span(reinterpret_cast<const char*>(vals.data()), 8);
+      REQUIRE_THROWS_AS(journal.inject(val, ActorSet{ids.nth(0), 999}, bytes), std::invalid_argument);
+      REQUIRE(table.field(val).get<uint32_t>(table.slot(ids.nth(0))) == 0);
+      journal.inject(val, ids, bytes);
+      journal.inject(state, ids, bytes);
+      journal.inject(tag, ids, bytes);
+      if (tick % 2 == 1) journal.despawn(ActorSet{table.actorAt(0)});
+      REQUIRE_THROWS_AS(journal.snapshot(), std::logic_error);
+      step_(table, val, tick);
+      journal.endTick();
+      states.push_back(state_(table));
+    }
+    REQUIRE(journal.tick() == 6);
+    journal.flush();
+  }
+
+  JournalReplay replay(path);
+  REQUIRE(replay.numTicks() == 6);
+  REQUIRE(replay.snapshotTicks() == std::vector<uint64_t>{0, 3});
+
+  SECTION("full replay") {
+    Table replayed(&type);
+    std::vector<std::vector<char>> replayed_states;
+    auto start = replay.run(replayed, 0, 6, [&](uint64_t tick) {
+      step_(replayed, val, tick);
+      replayed_states.push_back(state_(replayed));
+    });
+    REQUIRE(start == 0);
+    REQUIRE(replayed_states == states);
+  }
+  SECTION("window") {
+    Table replayed(&type);
+    auto start = replay.run(replayed, 4, 5, [&](uint64_t tick) { step_(replayed, val, tick); });
+    REQUIRE(start == 3);
+    REQUIRE(state_(replayed) == states[4]);
+  }
+  SECTION("truncated journal") {
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3);
+    JournalReplay truncated(path);
+    REQUIRE(truncated.numTicks() == 5);
+    Table replayed(&type);
+    REQUIRE_THROWS_AS(truncated.run(replayed, 0, 6), std::out_of_range);
+  }
+  std::filesystem::remove(path);
+}
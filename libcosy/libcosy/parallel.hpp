@@ -0,0 +1,45 @@
+#ifndef parallel_hpp_INCLUDED
+#define parallel_hpp_INCLUDED
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <thread>
+#include <vector>
+
+// Passes over [0, n) split into equal chunks, one per thread. Spawning
+// threads only pays off when each gets enough work, so the number of
+// chunks is bounded by a minimum chunk size.
+
+// The number of chunks to split n items into: threads, or one per hardware
+// thread if 0, but none smaller than min_per_chunk items.
+inline auto numChunks(uint64_t n, unsigned threads, uint64_t min_per_chunk) ->unsigned {
+  if (threads == 0) threads = std::max(std::thread::hardware_concurrency(), 1u);
+  return std::clamp<uint64_t>(n / min_per_chunk, 1, threads);
+}
+
+// Runs fn(t, first, last) on the t-th of chunks equal parts of [0, n). The
+// first part runs on the calling thread, the others on their own. Once all
+// parts are done, the exception of the first part that threw is rethrown
+// on the calling thread.
+template<class Fn>
+void forChunks(uint64_t n, unsigned chunks, Fn fn) {
+  auto chunk = (n + chunks - 1) / chunks;
+  std::vector<std::exception_ptr> errors(chunks);
+  auto run = [&fn, &errors, chunk, n](unsigned t) {
+    try {
+      fn(t, std::min(n, t * chunk), std::min(n, (t + 1) * chunk));
+    } catch (...) {
+      errors[t] = std::current_exception();
+    }
+  };
+  {
+    std::vector<std::jthread> workers;
+    for (unsigned t = 1; t < chunks; ++t) workers.emplace_back(run, t);
+    run(0);
+  }
+  for (auto& error : errors)
+    if (error) std::rethrow_exception(error);
+}
+
+#endif // parallel_hpp_INCLUDED
@@ -0,0 +1,143 @@
+#include <libcosy/primitive_type.hpp>
+
+#include <charconv>
+#include <format>
+#include <stdexcept>
+
+namespace {
+  constexpr Element scalars_[] = {
+    Element::i8, Element::i16, Element::i32, Element::i64,
+    Element::u8, Element::u16, Element::u32, Element::u64,
+    Element::f32, Element::f64,
+  };
+
+  // Arrays are limited so that sizes stay well within int.
+  constexpr int max_array_lanes_ = 1 << 20;
+}
+
+auto elementSize(Element element) ->int {
+  switch (element) {
+  case Element::i8:  case Element::u8:  return 1;
+  case Element::i16: case Element::u16: return 2;
+  case Element::i32: case Element::u32: case Element::f32: return 4;
+  case Element::i64: case Element::u64: case Element::f64: return 8;
+  }
+  return 0;
+}
+
+auto elementName(Element element) ->const char* {
+  switch (element) {
+  case Element::i8:  return "i8";
+  case Element::i16: return "i16";
+  case Element::i32: return "i32";
+  case Element::i64: return "i64";
+  case Element::u8:  return "u8";
+  case Element::u16: return "u16";
+  case Element::u32: return "u32";
+  case Element::u64: return "u64";
+  case Element::f32: return "f32";
+  case Element::f64: return "f64";
+  }
+  return "";
+}
+
+PrimitiveType::PrimitiveType(const std::string& name, Element element, int lanes, Shape shape):
+  AttributeType(name),
+  element_(element),
+  lanes_(lanes),
+  shape_(shape) {
+  if (lanes < 1) throw std::invalid_argument(std::format("type '{}' needs at least one lane", name));
+}
+
+auto PrimitiveType::size() ->int {
+  return elementSize() * lanes_;
+}
+
+auto PrimitiveType::alignment() ->int {
+  if (shape_ == Shape::vector && (lanes_ == 2 || lanes_ == 4)) return size();
+  return elementSize();
+}
+
+auto PrimitiveType::element() const ->Element {
+  return element_;
+}
+
+auto PrimitiveType::elementSize() const ->int {
+  return ::elementSize(element_);
+}
+
+auto PrimitiveType::lanes() const ->int {
+  return lanes_;
+}
+
+auto PrimitiveType::shape() const ->PrimitiveType::Shape {
+  return shape_;
+}
+
+TypeRegistry::TypeRegistry() {
+  using Shape = PrimitiveType::Shape;
+  auto add = [this](const std::string& name, Element element, int lanes, Shape shape) {
+    types_.emplace(name, std::make_unique<PrimitiveType>(name, element, lanes, shape));
+  };
+  for (auto element: scalars_) add(elementName(element), element, 1, Shape::scalar);
+  for (int lanes = 2; lanes <= 4; ++lanes) {
+    add(std::format("vec{}", lanes), Element::f32, lanes, Shape::vector);
+    add(std::format("dvec{}", lanes), Element::f64, lanes, Shape::vector);
+    add(std::format("ivec{}", lanes), Element::i32, lanes, Shape::vector);
+  }
+  add("flags8", Element::u8, 1, Shape::flags);
+  add("flags16", Element::u16, 1, Shape::flags);
+  add("flags32", Element::u32, 1, Shape::flags);
+  add("flags64", Element::u64, 1, Shape::flags);
+}
+
+auto TypeRegistry::global() ->TypeRegistry& {
+  static TypeRegistry registry;
+  return registry;
+}
+
+auto TypeRegistry::get(const std::string& name) ->AttributeType* {
+  std::lock_guard lock(mutex_);
+  auto type = find_(name);
+  if (type == nullptr) throw std::invalid_argument(std::format("no attribute type named '{}'", name));
+  return type;
+}
+
+auto TypeRegistry::primitive(const std::string& name) ->PrimitiveType* {
+  auto type = dynamic_cast<PrimitiveType*>(get(name));
+  if (type == nullptr) throw std::invalid_argument(std::format("attribute type '{}' is not primitive", name));
+  return type;
+}
+
+auto TypeRegistry::contains(const std::string& name) ->bool {
+  std::lock_guard lock(mutex_);
+  return find_(name) != nullptr;
+}
+
+auto TypeRegistry::add(std::unique_ptr<AttributeType> type) ->AttributeType* {
+  std::lock_guard lock(mutex_);
+  auto name = type->name;
+  if (find_(name) != nullptr) throw std::invalid_argument(std::format("attribute type '{}' already exists", name));
+  return types_.emplace(name, std::move(type)).first->second.get();
+}
+
+// Array types are parsed from their name, as element[lanes].
+auto TypeRegistry::find_(const std::string& name) ->AttributeType* {
+  if (auto it = types_.find(name); it != types_.end()) return it->second.get();
+
+  auto open = name.find('[');
+  if (open == std::string::npos || name.back() != ']') return nullptr;
+  auto elem = types_.find(name.substr(0, open));
+  if (elem == types_.end()) return nullptr;
+  auto scalar = dynamic_cast<PrimitiveType*>(elem->second.get());
+  if (scalar == nullptr || scalar->shape() != PrimitiveType::Shape::scalar) return nullptr;
+  int lanes = 0;
+  auto first = name.data() + open + 1, last = name.data() + name.size() - 1;
+  auto [ptr, ec] = std::from_chars(first, last, lanes);
+  if (ec != std::errc() || ptr != last || lanes < 1 || lanes > max_array_lanes_) return nullptr;
+
+  auto canonical = std::format("{}[{}]", scalar->name, lanes);
+  if (canonical != name) return nullptr;
+  auto type = std::make_unique<PrimitiveType>(name, scalar->element(), lanes, PrimitiveType::Shape::array);
+  return types_.emplace(name, std::move(type)).first->second.get();
+}
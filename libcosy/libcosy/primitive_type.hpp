@@ -0,0 +1,80 @@
+#ifndef primitive_type_hpp_INCLUDED
+#define primitive_type_hpp_INCLUDED
+
+#include <libcosy/attribute_type.hpp>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+enum class Element { i8, i16, i32, i64, u8, u16, u32, u64, f32, f64 };
+
+auto elementSize(Element) ->int;
+auto elementName(Element) ->const char*;
+
+// An attribute type made of lanes of one element type. Scalars have one
+// lane; vectors and fixed-size arrays have several, stored consecutively.
+// Flags are unsigned integers used as bit sets.
+class PrimitiveType: public AttributeType {
+public:
+
+  enum class Shape { scalar, vector, array, flags };
+
+  PrimitiveType(const std::string& name, Element element, int lanes = 1, Shape shape = Shape::scalar);
+
+  // Vectors of two and four lanes are aligned to their size, so that they
+  // load as one SIMD register; everything else to its element size.
+  auto size()      -> int override;
+  auto alignment() -> int override;
+
+  auto element() const ->Element;
+  auto elementSize() const ->int;
+  auto lanes() const ->int;
+  auto shape() const ->Shape;
+
+private:
+
+  Element element_;
+  int     lanes_;
+  Shape   shape_;
+};
+
+// Attribute types by name. A registry starts out with the built-in
+// primitive types:
+//
+//   i8 i16 i32 i64 u8 u16 u32 u64 f32 f64  scalars
+//   vec2 vec3 vec4                          f32 vectors
+//   dvec2 dvec3 dvec4                       f64 vectors
+//   ivec2 ivec3 ivec4                       i32 vectors
+//   flags8 flags16 flags32 flags64          bit flags
+//
+// Arrays of a scalar type, named like f32[16], are created on first use.
+class TypeRegistry {
+public:
+
+  TypeRegistry();
+
+  TypeRegistry(const TypeRegistry&) = delete;
+  auto operator = (const TypeRegistry&) ->TypeRegistry& = delete;
+
+  // The registry shared by the whole process.
+  static auto global() ->TypeRegistry&;
+
+  // Throws std::invalid_argument if there is no type of that name.
+  auto get(const std::string& name) ->AttributeType*;
+  auto primitive(const std::string& name) ->PrimitiveType*;
+  auto contains(const std::string& name) ->bool;
+
+  // Registers a type under its name, which must not be taken.
+  auto add(std::unique_ptr<AttributeType> type) ->AttributeType*;
+
+private:
+
+  auto find_(const std::string& name) ->AttributeType*;
+
+  std::mutex                                                      mutex_;
+  std::unordered_map<std::string, std::unique_ptr<AttributeType>> types_;
+};
+
+#endif // primitive_type_hpp_INCLUDED
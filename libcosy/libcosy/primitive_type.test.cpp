@@ -0,0 +1,52 @@
+#include <libcosy/primitive_type.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <memory>
+#include <stdexcept>
+
+TEST_CASE("PrimitiveType", "[PrimitiveType]") {
+  PrimitiveType vec4("vec4", Element::f32, 4, PrimitiveType::Shape::vector);
+  REQUIRE(vec4.size() == 16);
+  REQUIRE(vec4.alignment() == 16);
+  REQUIRE(vec4.lanes() == 4);
+  REQUIRE(vec4.elementSize() == 4);
+
+  PrimitiveType vec3("vec3", Element::f32, 3, PrimitiveType::Shape::vector);
+  REQUIRE(vec3.size() == 12);
+  REQUIRE(vec3.alignment() == 4);
+
+  REQUIRE_THROWS_AS(PrimitiveType("empty", Element::u8, 0), std::invalid_argument);
+}
+
+TEST_CASE("TypeRegistry", "[PrimitiveType]") {
+  TypeRegistry registry;
+
+  SECTION("built-in types") {
+    REQUIRE(registry.primitive("i16")->size() == 2);
+    REQUIRE(registry.primitive("f64")->element() == Element::f64);
+    REQUIRE(registry.primitive("dvec2")->alignment() == 16);
+    REQUIRE(registry.primitive("ivec3")->lanes() == 3);
+    REQUIRE(registry.primitive("flags32")->shape() == PrimitiveType::Shape::flags);
+    REQUIRE(!registry.contains("vec5"));
+    REQUIRE_THROWS_AS(registry.get("vec5"), std::invalid_argument);
+  }
+  SECTION("arrays") {
+    auto arr = registry.primitive("f32[16]");
+    REQUIRE(arr->size() == 64);
+    REQUIRE(arr->alignment() == 4);
+    REQUIRE(arr->shape() == PrimitiveType::Shape::array);
+    REQUIRE(registry.get("f32[16]") == arr);
+    for (auto name: {"f32[0]", "f32[016]", "vec2[4]", "f32[4", "f32[x]", "q8[2]"})
+      REQUIRE(!registry.contains(name));
+  }
+  SECTION("custom types") {
+    auto type = registry.add(std::make_unique<PrimitiveType>("rgba", Element::u8, 4, PrimitiveType::Shape::vector));
+    REQUIRE(registry.get("rgba") == type);
+    REQUIRE_THROWS_AS(
+      registry.add(std::make_unique<PrimitiveType>("f32", Element::f32)),
+      std::invalid_argument
+    );
+  }
+  REQUIRE(TypeRegistry::global().get("u64")->size() == 8);
+}
@@ -1,25 +1,175 @@
 #include <libcosy/record_type.hpp>
 
-RecordType::RecordType(std::initializer_list<Attribute> list): attributes_(list) {
+#include <bit>
+#include <map>
+
+namespace {
+  auto roundUp_(size_t n, size_t multiple) ->size_t {
+    return ((n + multiple - 1) / multiple) * multiple;
+  }
+}
+
+RecordType::RecordType(std::initializer_list<Attribute> list):
+  RecordType(std::vector<Attribute>(list)) {}
+
+RecordType::RecordType(std::vector<Attribute> attributes): attributes_(std::move(attributes)) {
   std::unordered_set<std::string> names;
   for (const auto& attr: attributes_) {
     if (attr.name.size() == 0)
       throw std::invalid_argument("attribute must be named");
     if (!names.insert(attr.name).second)
       throw std::invalid_argument(std::format("multiple attributes named '{}'", attr.name));
+    if (attr.cold && attr.double_buffered)
+      throw std::invalid_argument(std::format("cold attribute '{}' cannot be double-buffered", attr.name));
+    if (attr.column && (attr.cold || attr.double_buffered))
+      throw std::invalid_argument(std::format("column attribute '{}' cannot be cold or double-buffered", attr.name));
   }
 
-  size_ = 0;
-  if (attributes_.size() == 0) return;
   ranges::sort(attributes_, Attribute::lessMemoryOrder);
+  size_          = layout_(false);
+  buffered_size_ = layout_(true);
+  num_cold_      = 0;
+  num_columns_   = 0;
   for (auto& attr: attributes_) {
-    attr.offset = size_;
-    size_ += attr.type->size();
+    if (attr.cold)   attr.offset = num_cold_++;
+    if (attr.column) attr.offset = num_columns_++;
   }
-  auto alignment = attributes_[0].type->alignment();
-  size_ = ((size_ + alignment - 1) / alignment) * alignment;
 }
 
 auto RecordType::size() const ->size_t {
   return size_;
 }
+
+auto RecordType::bufferedSize() const ->size_t {
+  return buffered_size_;
+}
+
+auto RecordType::numColdAttributes() const ->size_t {
+  return num_cold_;
+}
+
+auto RecordType::numColumnAttributes() const ->size_t {
+  return num_columns_;
+}
+
+auto RecordType::attributes() const ->const std::vector<Attribute>& {
+  return attributes_;
+}
+
+auto RecordType::attribute(const std::string& name) const ->const Attribute* {
+  auto it = ranges::find(attributes_, name, &Attribute::name);
+  return it == attributes_.end()? nullptr : &*it;
+}
+
+auto RecordType::layoutReport() const ->LayoutReport {
+  LayoutReport report{.size = size_, .padding = size_, .lines = {}, .split = {}};
+  for (const auto& attr: attributes_) {
+    if (attr.cold || attr.column || attr.double_buffered) continue;
+    size_t size = attr.type->size();
+    report.padding -= size;
+    auto first = attr.offset / cache_line_size;
+    auto last  = size > 0? (attr.offset + size - 1) / cache_line_size : first;
+    if (report.lines.size() <= last) report.lines.resize(last + 1);
+    for (auto line = first; line <= last; ++line) report.lines[line].push_back(attr.name);
+    if (first != last) report.split.push_back(attr.name);
+  }
+  return report;
+}
+
+// Fields are placed in units: an access group is packed into one unit and
+// every other attribute is a unit of its own. Group units are placed first
+// fit into cache lines, and the remaining units fill the tails of those
+// lines before being appended. Units are placed in order of decreasing
+// alignment, so without groups padding is only needed behind units whose
+// size is not a multiple of their alignment, and at the end of the record.
+auto RecordType::layout_(bool double_buffered) ->size_t {
+  struct Unit_ {
+    std::vector<Attribute*> attributes;
+    size_t                  size      = 0;
+    size_t                  alignment = 1;
+  };
+
+  auto place = [](Unit_& unit, Attribute& attr) {
+    size_t alignment = attr.type->alignment();
+    attr.offset    = roundUp_(unit.size, alignment);
+    unit.size      = attr.offset + attr.type->size();
+    unit.alignment = std::max(unit.alignment, alignment);
+    unit.attributes.push_back(&attr);
+  };
+
+  std::map<std::string, Unit_> groups;
+  std::vector<Unit_>           singles;
+  for (auto& attr: attributes_) {
+    if (attr.cold || attr.column || attr.double_buffered != double_buffered) continue;
+    if (attr.group.empty()) place(singles.emplace_back(), attr);
+    else place(groups[attr.group], attr);
+  }
+  if (groups.empty() && singles.empty()) return 0;
+
+  std::vector<Unit_*> grouped;
+  for (auto& [name, unit]: groups) grouped.push_back(&unit);
+  ranges::stable_sort(grouped, std::greater{}, &Unit_::size);
+
+  size_t alignment = 1;
+  auto commit = [&alignment](Unit_& unit, size_t offset) {
+    for (auto attr: unit.attributes) attr->offset += offset;
+    alignment = std::max(alignment, unit.alignment);
+  };
+
+  std::vector<size_t> lines; // bytes used in each cache line
+
+  // Places unit at the first aligned offset with room among the first
+  // num_lines lines, if any.
+  auto fill = [&lines, &commit](Unit_& unit, size_t num_lines) ->bool {
+    for (size_t line = 0; line < num_lines; ++line) {
+      auto offset = roundUp_(line * cache_line_size + lines[line], unit.alignment);
+      if (offset + unit.size > (line + 1) * cache_line_size) continue;
+      lines[line] = offset + unit.size - line * cache_line_size;
+      commit(unit, offset);
+      return true;
+    }
+    return false;
+  };
+
+  // Units aligned beyond a cache line may skip lines, which are left full.
+  for (auto unit: grouped) {
+    if (unit->size <= cache_line_size && fill(*unit, lines.size())) continue;
+    auto offset = roundUp_(lines.size() * cache_line_size, unit->alignment);
+    auto num    = std::max<size_t>((unit->size + cache_line_size - 1) / cache_line_size, 1);
+    lines.resize(offset / cache_line_size + num, cache_line_size);
+    lines.back() = unit->size - (num - 1) * cache_line_size;
+    commit(*unit, offset);
+  }
+
+  size_t end = lines.empty()? 0 : (lines.size() - 1) * cache_line_size + lines.back();
+  for (auto& unit: singles) {
+    if (lines.size() > 1 && fill(unit, lines.size() - 1)) continue;
+    auto offset = roundUp_(end, unit.alignment);
+    end = offset + unit.size;
+    commit(unit, offset);
+  }
+  end = std::max(end, lines.empty()? 0 : (lines.size() - 1) * cache_line_size + lines.back());
+
+  // Grouping only holds if records do not straddle cache lines, so records
+  // with groups tile cache lines exactly.
+  if (!groups.empty()) {
+    if (end >= cache_line_size) return roundUp_(end, std::max(cache_line_size, alignment));
+    return std::max(std::bit_ceil(end), alignment);
+  }
+  return roundUp_(end, alignment);
+}
+
+std::ostream& operator << (std::ostream& os, const LayoutReport& report) {
+  os << std::format("size {}, padding {}\n", report.size, report.padding);
+  for (size_t line = 0; line < report.lines.size(); ++line) {
+    os << std::format("line {}:", line);
+    for (const auto& name: report.lines[line]) os << ' ' << name;
+    os << '\n';
+  }
+  if (!report.split.empty()) {
+    os << "split:";
+    for (const auto& name: report.split) os << ' ' << name;
+    os << '\n';
+  }
+  return os;
+}
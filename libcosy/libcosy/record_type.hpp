@@ -8,19 +8,46 @@
 #include <stdexcept>
 #include <format>
 #include <algorithm>
+#include <iosfwd>
 
 namespace ranges = std::ranges;
 
+// Layout of the in-record attributes of a record type, assuming records
+// start at a cache line boundary.
+struct LayoutReport {
+  size_t                                size;
+  size_t                                padding;
+  std::vector<std::vector<std::string>> lines; // attributes in each cache line
+  std::vector<std::string>              split; // attributes spanning two lines
+};
+
+std::ostream& operator << (std::ostream&, const LayoutReport&);
+
 class RecordType {
 public:
 
+  static constexpr size_t cache_line_size = 64;
+
   RecordType(std::initializer_list<Attribute> list);
+  RecordType(std::vector<Attribute> attributes);
 
   auto size() const ->size_t;
+  auto bufferedSize() const ->size_t;
+  auto numColdAttributes() const ->size_t;
+  auto numColumnAttributes() const ->size_t;
+  auto layoutReport() const ->LayoutReport;
+
+  auto attributes() const ->const std::vector<Attribute>&;
+  auto attribute(const std::string& name) const ->const Attribute*;
 
 private:
 
+  auto layout_(bool double_buffered) ->size_t;
+
   size_t size_;
+  size_t buffered_size_;
+  size_t num_cold_;
+  size_t num_columns_;
   std::vector<Attribute> attributes_;
 };
 
@@ -40,3 +40,60 @@ TEST_CASE("RecordType::size", "[RecordType]") {
     Attribute{.name = "attr 4", .type = &atm1x1},
   }.size() == 12);
 }
+
+TEST_CASE("RecordType: attribute alignment", "[RecordType]") {
+  AttributeTypeMock atm6x4 {"type mock 6x4", 6, 4};
+  AttributeTypeMock atm4x4 {"type mock 4x4", 4, 4};
+  AttributeTypeMock atm1x1 {"type mock 1x1", 1, 1};
+
+  RecordType type{
+    Attribute{.name = "attr 1", .type = &atm1x1},
+    Attribute{.name = "attr 2", .type = &atm4x4},
+    Attribute{.name = "attr 3", .type = &atm6x4},
+  };
+  REQUIRE(type.attribute("attr 3")->offset == 0);
+  REQUIRE(type.attribute("attr 2")->offset == 8);
+  REQUIRE(type.attribute("attr 1")->offset == 12);
+  REQUIRE(type.size() == 16);
+  REQUIRE(type.layoutReport().padding == 5);
+}
+
+TEST_CASE("RecordType: access groups", "[RecordType]") {
+  AttributeTypeMock atm8x8 {"type mock 8x8", 8, 8};
+
+  std::vector<Attribute> attributes;
+  for (auto name: {"x1", "x2", "x3", "x4", "x5", "x6", "x7"})
+    attributes.push_back(Attribute{.name = name, .type = &atm8x8});
+  attributes.push_back(Attribute{.name = "hot 1", .type = &atm8x8, .group = "hot"});
+  attributes.push_back(Attribute{.name = "hot 2", .type = &atm8x8, .group = "hot"});
+
+  RecordType type(attributes);
+  REQUIRE(type.attribute("hot 1")->offset / 64 == type.attribute("hot 2")->offset / 64);
+  REQUIRE(type.size() == 128);
+
+  auto report = type.layoutReport();
+  REQUIRE(report.lines.size() == 2);
+  REQUIRE(report.split.empty());
+  REQUIRE(report.padding == 56);
+
+  AttributeTypeMock atm8x128 {"type mock 8x128", 8, 128};
+  RecordType wide{
+    Attribute{.name = "a", .type = &atm8x8,   .group = "a"},
+    Attribute{.name = "b", .type = &atm8x128, .group = "b"},
+  };
+  REQUIRE(wide.attribute("b")->offset % 128 == 0);
+  REQUIRE(wide.size() % 128 == 0);
+}
+
+TEST_CASE("RecordType::layoutReport", "[RecordType]") {
+  AttributeTypeMock atm48x1 {"type mock 48x1", 48, 1};
+  RecordType type{
+    Attribute{.name = "attr 1", .type = &atm48x1},
+    Attribute{.name = "attr 2", .type = &atm48x1},
+  };
+  auto report = type.layoutReport();
+  REQUIRE(report.size == 96);
+  REQUIRE(report.padding == 0);
+  REQUIRE(report.split == std::vector<std::string>{"attr 2"});
+  REQUIRE(report.lines == std::vector<std::vector<std::string>>{{"attr 1", "attr 2"}, {"attr 2"}});
+}
@@ -0,0 +1,265 @@
+#ifndef reduce_hpp_INCLUDED
+#define reduce_hpp_INCLUDED
+
+#include <libcosy/parallel.hpp>
+#include <libcosy/table.hpp>
+
+#include <algorithm>
+#include <concepts>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// Reductions over one attribute of a table, read as values of type T.
+// Records are processed in blocks: the field is gathered from a block of
+// records into a contiguous array which the reduction kernels then run
+// over, so that the compiler can vectorize them. Large tables are split
+// over threads.
+
+template<class T> requires std::is_arithmetic_v<T>
+struct Stats {
+  using Sum = std::conditional_t<
+    std::is_floating_point_v<T>, double,
+    std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>>;
+
+  uint64_t count = 0;
+  Sum      sum   = 0;
+  T        min   = std::numeric_limits<T>::max();
+  T        max   = std::numeric_limits<T>::lowest();
+
+  void merge(const Stats& other) {
+    count += other.count;
+    sum   += other.sum;
+    min    = std::min(min, other.min);
+    max    = std::max(max, other.max);
+  }
+};
+
+// Histogram of values in [lo, hi) over equally wide bins. Values outside
+// the range are counted in the first and last bin.
+template<class T> requires std::is_arithmetic_v<T>
+struct Histogram {
+  T                     lo, hi;
+  std::vector<uint64_t> bins;
+
+  Histogram(T l, T h, size_t num_bins): lo(l), hi(h), bins(num_bins, 0) {
+    if (num_bins == 0 || !(lo < hi)) throw std::invalid_argument("invalid histogram range");
+  }
+
+  auto bin(T val) const ->size_t {
+    if (val < lo) return 0;
+    auto idx = size_t(distance_(lo, val) * bins.size() / distance_(lo, hi));
+    return std::min(idx, bins.size() - 1);
+  }
+
+  void merge(const Histogram& other) {
+    for (size_t i = 0; i < bins.size(); ++i) bins[i] += other.bins[i];
+  }
+
+private:
+
+  // to - from for from <= to, which overflows signed T over wide ranges.
+  static auto distance_(T from, T to) ->double {
+    if constexpr (std::is_integral_v<T>) {
+      using U = std::make_unsigned_t<T>;
+      return double(U(U(to) - U(from)));
+    } else {
+      return double(to) - double(from);
+    }
+  }
+};
+
+namespace reduce_detail {
+
+  constexpr size_t block_size         = 256;
+  constexpr size_t min_slots_per_task = 1 << 16;
+
+  inline auto fieldOf(Table& table, const Attribute& attr) ->ConstFieldView {
+    if (attr.cold) throw std::invalid_argument(std::format("attribute '{}' is cold", attr.name));
+    if (attr.double_buffered) return table.current(attr);
+    return table.field(attr);
+  }
+
+  template<class T>
+  void gather(ConstFieldView field, uint64_t first, size_t n, T* out) {
+    for (size_t i = 0; i < n; ++i) out[i] = field.get<T>(first + i);
+  }
+
+  template<class T>
+  void gather(ConstFieldView field, const Table& table, const ActorId* ids, size_t n, T* out) {
+    for (size_t i = 0; i < n; ++i) out[i] = field.get<T>(table.slot(ids[i]));
+  }
+
+  template<class T>
+  void accumulate(Stats<T>& stats, const T* vals, size_t n) {
+    typename Stats<T>::Sum sum = 0;
+    T min = stats.min, max = stats.max;
+    for (size_t i = 0; i < n; ++i) {
+      sum += vals[i];
+      min  = vals[i] < min? vals[i] : min;
+      max  = vals[i] > max? vals[i] : max;
+    }
+    stats.count += n;
+    stats.sum   += sum;
+    stats.min    = min;
+    stats.max    = max;
+  }
+
+  template<class T>
+  void accumulate(Histogram<T>& hist, const T* vals, size_t n) {
+    for (size_t i = 0; i < n; ++i) ++hist.bins[hist.bin(vals[i])];
+  }
+
+  // Runs fn(first, last, result) on chunks of [0, n) in parallel and merges
+  // the results into init.
+  template<class R, class Fn>
+  auto parallel(uint64_t n, unsigned threads, R init, Fn fn) ->R {
+    threads = numChunks(n, threads, min_slots_per_task);
+    std::vector<R> results(threads, init);
+    forChunks(n, threads, [&](unsigned t, uint64_t first, uint64_t last) { fn(first, last, results[t]); });
+    for (unsigned t = 1; t < threads; ++t) results[0].merge(results[t]);
+    return results[0];
+  }
+
+  template<class T, class R>
+  auto reduce(Table& table, const Attribute& attr, R init, unsigned threads) ->R {
+    auto field = fieldOf(table, attr);
+    return parallel(table.numActors(), threads, init, [field](uint64_t first, uint64_t last, R& res) {
+      T vals[block_size];
+      for (auto slot = first; slot < last; slot += block_size) {
+        auto n = std::min<uint64_t>(block_size, last - slot);
+        gather(field, slot, n, vals);
+        accumulate(res, vals, n);
+      }
+    });
+  }
+
+  template<class T, class R>
+  auto reduce(Table& table, const Attribute& attr, const ActorSet& ids, R init, unsigned threads) ->R {
+    auto field = fieldOf(table, attr);
+    std::vector<ActorId> flat;
+    flat.reserve(ids.size());
+    ids.forEach([&flat](ActorId id) { flat.push_back(id); });
+    return parallel(flat.size(), threads, init, [&](uint64_t first, uint64_t last, R& res) {
+      T vals[block_size];
+      for (auto i = first; i < last; i += block_size) {
+        auto n = std::min<uint64_t>(block_size, last - i);
+        gather(field, table, flat.data() + i, n, vals);
+        accumulate(res, vals, n);
+      }
+    });
+  }
+}
+
+template<class T>
+auto stats(Table& table, const Attribute& attr, unsigned threads = 0) ->Stats<T> {
+  return reduce_detail::reduce<T>(table, attr, Stats<T>{}, threads);
+}
+
+template<class T>
+auto stats(Table& table, const Attribute& attr, const ActorSet& ids, unsigned threads = 0) ->Stats<T> {
+  return reduce_detail::reduce<T>(table, attr, ids, Stats<T>{}, threads);
+}
+
+template<class T>
+auto histogram(Table& table, const Attribute& attr, T lo, T hi, size_t bins, unsigned threads = 0)
+  ->Histogram<T> {
+  return reduce_detail::reduce<T>(table, attr, Histogram<T>(lo, hi, bins), threads);
+}
+
+template<class T>
+auto histogram(
+  Table&           table,
+  const Attribute& attr,
+  const ActorSet&  ids,
+  T lo, T hi, size_t bins,
+  unsigned threads = 0
+) ->Histogram<T> {
+  return reduce_detail::reduce<T>(table, attr, ids, Histogram<T>(lo, hi, bins), threads);
+}
+
+// Statistics over an attribute kept up to date from tracked writes instead
+// of rescanning. Count, sum and histogram are updated from deltas; min and
+// max are invalidated when the current extreme is overwritten or removed,
+// and recomputed by a scan when next asked for. The table and the attribute
+// are referenced, not copied, so they have to outlive the stats.
+template<class T> requires std::is_arithmetic_v<T>
+class IncrementalStats {
+public:
+
+  IncrementalStats(Table& table, const Attribute& attr, std::optional<Histogram<T>> hist = {}):
+    table_(table),
+    attr_(&attr),
+    hist_(std::move(hist)) {
+    if (attr.cold || attr.column || attr.double_buffered)
+      throw std::invalid_argument(std::format("attribute '{}' cannot be tracked", attr.name));
+    rescan();
+  }
+
+  // Writes val to the actor's field.
+  void set(ActorId id, T val) {
+    auto field = table_.field(*attr_);
+    auto slot  = table_.slot(id);
+    remove_(field.get<T>(slot));
+    field.set<T>(slot, val);
+    add_(val);
+  }
+
+  // Accounts for actors added to or about to be removed from the table.
+  void insert(ActorId id) {
+    add_(table_.field(*attr_).get<T>(table_.slot(id)));
+  }
+  void erase(ActorId id) {
+    remove_(table_.field(*attr_).get<T>(table_.slot(id)));
+  }
+
+  void rescan() {
+    stats_ = ::stats<T>(table_, *attr_);
+    if (hist_) hist_ = ::histogram<T>(table_, *attr_, hist_->lo, hist_->hi, hist_->bins.size());
+    extremes_valid_ = true;
+  }
+
+  auto stats() ->const Stats<T>& {
+    if (!extremes_valid_) {
+      auto scanned = ::stats<T>(table_, *attr_);
+      stats_.min = scanned.min;
+      stats_.max = scanned.max;
+      extremes_valid_ = true;
+    }
+    return stats_;
+  }
+
+  auto histogram() const ->const Histogram<T>& {
+    if (!hist_) throw std::logic_error("no histogram is tracked");
+    return *hist_;
+  }
+
+private:
+
+  void add_(T val) {
+    ++stats_.count;
+    stats_.sum += val;
+    if (extremes_valid_) {
+      stats_.min = std::min(stats_.min, val);
+      stats_.max = std::max(stats_.max, val);
+    }
+    if (hist_) ++hist_->bins[hist_->bin(val)];
+  }
+
+  void remove_(T val) {
+    --stats_.count;
+    stats_.sum -= val;
+    if (val == stats_.min || val == stats_.max) extremes_valid_ = false;
+    if (hist_) --hist_->bins[hist_->bin(val)];
+  }
+
+  Table&                      table_;
+  const Attribute*            attr_;
+  Stats<T>                    stats_;
+  std::optional<Histogram<T>> hist_;
+  bool                        extremes_valid_ = false;
+};
+
+#endif // reduce_hpp_INCLUDED
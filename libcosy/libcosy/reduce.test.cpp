@@ -0,0 +1,72 @@
+#include <libcosy/mock/attribute_type.hpp>
+#include <libcosy/reduce.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <stdexcept>
+
+namespace {
+  struct Fixture_ {
+    AttributeTypeMock atm {"type mock", 4, 4};
+    ActorType         type {"actor", RecordType{
+      Attribute{.name = "pad", .type = &atm},
+      Attribute{.name = "val", .type = &atm},
+    }};
+    const Attribute&  val = *type.attribute("val");
+    Table             table {&type};
+
+    Fixture_(int32_t n) {
+      table.newActors(n);
+      for (int32_t slot = 0; slot < n; ++slot) table.field(val).set<int32_t>(slot, slot - 10);
+    }
+  };
+}
+
+TEST_CASE("stats", "[reduce]") {
+  Fixture_ f(300'000);
+
+  auto all = stats<int32_t>(f.table, f.val, 4);
+  REQUIRE(all.count == 300'000);
+  REQUIRE(all.sum == int64_t(299'999) * 300'000 / 2 - 10 * 300'000);
+  REQUIRE(all.min == -10);
+  REQUIRE(all.max == 299'989);
+
+  auto some = stats<int32_t>(f.table, f.val, ActorSet{{1, 5}, {11, 11}});
+  REQUIRE(some.count == 6);
+  REQUIRE(some.sum == -10 - 9 - 8 - 7 - 6 + 0);
+  REQUIRE(some.min == -10);
+  REQUIRE(some.max == 0);
+
+  REQUIRE_THROWS_AS(stats<int32_t>(f.table, f.val, ActorSet{{1, 300'001}}, 4), std::out_of_range);
+}
+
+TEST_CASE("histogram", "[reduce]") {
+  Fixture_ f(40);
+  auto hist = histogram<int32_t>(f.table, f.val, 0, 20, 4);
+  REQUIRE(hist.bins == std::vector<uint64_t>{15, 5, 5, 15});
+
+  constexpr auto min = std::numeric_limits<int32_t>::min(), max = std::numeric_limits<int32_t>::max();
+  Histogram<int32_t> wide(min, max, 4);
+  REQUIRE(wide.bin(min) == 0);
+  REQUIRE(wide.bin(-1) == 1);
+  REQUIRE(wide.bin(0) == 2);
+  REQUIRE(wide.bin(max - 1) == 3);
+}
+
+TEST_CASE("IncrementalStats", "[reduce]") {
+  Fixture_ f(40);
+  IncrementalStats<int32_t> inc(f.table, f.val, Histogram<int32_t>(0, 20, 4));
+  REQUIRE(inc.stats().count == 40);
+
+  inc.set(1, 100);
+  inc.set(2, 5);
+  REQUIRE(inc.stats().min == -8);
+  REQUIRE(inc.stats().max == 100);
+  REQUIRE(inc.stats().sum == stats<int32_t>(f.table, f.val).sum);
+  REQUIRE(inc.histogram().bins == std::vector<uint64_t>{13, 6, 5, 16});
+
+  inc.erase(40);
+  f.table.deleteActor(40);
+  REQUIRE(inc.stats().count == 39);
+  REQUIRE(inc.stats().sum == stats<int32_t>(f.table, f.val).sum);
+}
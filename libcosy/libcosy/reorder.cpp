@@ -0,0 +1,100 @@
+#include <libcosy/reorder.hpp>
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+  auto spread2_(uint64_t v) ->uint64_t {
+    v &= 0xffffffff;
+    v = (v | (v << 16)) & 0x0000ffff0000ffff;
+    v = (v | (v << 8))  & 0x00ff00ff00ff00ff;
+    v = (v | (v << 4))  & 0x0f0f0f0f0f0f0f0f;
+    v = (v | (v << 2))  & 0x3333333333333333;
+    v = (v | (v << 1))  & 0x5555555555555555;
+    return v;
+  }
+
+  auto spread3_(uint64_t v) ->uint64_t {
+    v &= 0x1fffff;
+    v = (v | (v << 32)) & 0x001f00000000ffff;
+    v = (v | (v << 16)) & 0x001f0000ff0000ff;
+    v = (v | (v << 8))  & 0x100f00f00f00f00f;
+    v = (v | (v << 4))  & 0x10c30c30c30c30c3;
+    v = (v | (v << 2))  & 0x1249249249249249;
+    return v;
+  }
+}
+
+auto mortonKey(uint32_t x, uint32_t y) ->uint64_t {
+  return spread2_(x) | (spread2_(y) << 1);
+}
+
+auto mortonKey(uint32_t x, uint32_t y, uint32_t z) ->uint64_t {
+  return spread3_(x) | (spread3_(y) << 1) | (spread3_(z) << 2);
+}
+
+auto hilbertKey(uint32_t x, uint32_t y) ->uint64_t {
+  uint64_t key = 0;
+  for (uint64_t s = uint64_t(1) << 31; s > 0; s >>= 1) {
+    uint32_t rx = (x & s) > 0;
+    uint32_t ry = (y & s) > 0;
+    key += s * s * ((3 * rx) ^ ry);
+    if (ry == 0) {
+      if (rx == 1) {
+        x = ~x;
+        y = ~y;
+      }
+      std::swap(x, y);
+    }
+  }
+  return key;
+}
+
+auto keyOrder(const Table& table, const std::function<uint64_t(ActorId)>& key) ->std::vector<uint64_t> {
+  auto n = table.numActors();
+  std::vector<std::pair<uint64_t, uint64_t>> keyed(n);
+  for (uint64_t slot = 0; slot < n; ++slot) keyed[slot] = {key(table.actorAt(slot)), slot};
+  ranges::sort(keyed);
+  std::vector<uint64_t> order(n);
+  for (uint64_t i = 0; i < n; ++i) order[i] = keyed[i].second;
+  return order;
+}
+
+auto cuthillMcKeeOrder(
+  const Table& table,
+  const std::function<void(ActorId, std::vector<ActorId>&)>& neighbours
+) ->std::vector<uint64_t> {
+  auto n = table.numActors();
+  std::vector<std::vector<uint64_t>> adjacent(n);
+  std::vector<ActorId> ids;
+  for (uint64_t slot = 0; slot < n; ++slot) {
+    ids.clear();
+    neighbours(table.actorAt(slot), ids);
+    for (auto id: ids) if (table.contains(id)) adjacent[slot].push_back(table.slot(id));
+  }
+  auto degree = [&adjacent](uint64_t slot) { return adjacent[slot].size(); };
+
+  std::vector<uint64_t> by_degree(n);
+  std::iota(by_degree.begin(), by_degree.end(), 0);
+  ranges::stable_sort(by_degree, {}, degree);
+
+  std::vector<uint64_t> order;
+  std::vector<bool>     visited(n);
+  order.reserve(n);
+  for (auto start: by_degree) {
+    if (visited[start]) continue;
+    visited[start] = true;
+    order.push_back(start);
+    for (auto head = order.size() - 1; head < order.size(); ++head) {
+      auto& next = adjacent[order[head]];
+      ranges::stable_sort(next, {}, degree);
+      for (auto slot: next) {
+        if (visited[slot]) continue;
+        visited[slot] = true;
+        order.push_back(slot);
+      }
+    }
+  }
+  ranges::reverse(order);
+  return order;
+}
@@ -0,0 +1,29 @@
+#ifndef reorder_hpp_INCLUDED
+#define reorder_hpp_INCLUDED
+
+#include <libcosy/table.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Space-filling curve keys. Sorting by them keeps records of actors that
+// are close in space close in the table.
+auto mortonKey(uint32_t x, uint32_t y) ->uint64_t;
+auto mortonKey(uint32_t x, uint32_t y, uint32_t z) ->uint64_t; // 21 bits per coordinate
+auto hilbertKey(uint32_t x, uint32_t y) ->uint64_t;
+
+// Slot orders for Table::reorder.
+
+// Sorts the actors by a key.
+auto keyOrder(const Table& table, const std::function<uint64_t(ActorId)>& key) ->std::vector<uint64_t>;
+
+// Reverse Cuthill-McKee order of the graph over the table's actors, which
+// keeps neighbours close to each other. Neighbours outside the table are
+// ignored.
+auto cuthillMcKeeOrder(
+  const Table& table,
+  const std::function<void(ActorId, std::vector<ActorId>&)>& neighbours
+) ->std::vector<uint64_t>;
+
+#endif // reorder_hpp_INCLUDED
@@ -0,0 +1,48 @@
+#include <libcosy/mock/attribute_type.hpp>
+#include <libcosy/reorder.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdlib>
+
+TEST_CASE("mortonKey", "[reorder]") {
+  REQUIRE(mortonKey(0, 0) == 0);
+  REQUIRE(mortonKey(1, 0) == 1);
+  REQUIRE(mortonKey(0, 1) == 2);
+  REQUIRE(mortonKey(3, 3) == 15);
+  REQUIRE(mortonKey(1, 1, 1) == 7);
+  REQUIRE(mortonKey(2, 0, 0) == 8);
+}
+
+TEST_CASE("hilbertKey", "[reorder]") {
+  // Consecutive keys on the curve are adjacent cells.
+  std::vector<std::pair<uint32_t, uint32_t>> cells(64);
+  for (uint32_t x = 0; x < 8; ++x)
+    for (uint32_t y = 0; y < 8; ++y)
+      cells[hilbertKey(x, y) - hilbertKey(0, 0)] = {x, y};
+  for (size_t i = 1; i < cells.size(); ++i) {
+    auto dx = std::abs(int(cells[i].first)  - int(cells[i - 1].first));
+    auto dy = std::abs(int(cells[i].second) - int(cells[i - 1].second));
+    REQUIRE(dx + dy == 1);
+  }
+}
+
+TEST_CASE("cuthillMcKeeOrder", "[reorder]") {
+  AttributeTypeMock atm {"type mock", 4, 4};
+  ActorType type("actor", RecordType{Attribute{.name = "attr", .type = &atm}});
+  Table table(&type);
+  table.newActors(6);
+
+  // A path 1 - 4 - 2 - 6 - 3 - 5 ends up contiguous.
+  std::vector<ActorId> path{1, 4, 2, 6, 3, 5};
+  auto order = cuthillMcKeeOrder(table, [&path](ActorId id, std::vector<ActorId>& out) {
+    auto it = ranges::find(path, id);
+    if (it != path.begin()) out.push_back(*std::prev(it));
+    if (std::next(it) != path.end()) out.push_back(*std::next(it));
+  });
+  table.reorder(order);
+  for (size_t i = 1; i < path.size(); ++i) {
+    auto d = int64_t(table.slot(path[i])) - int64_t(table.slot(path[i - 1]));
+    REQUIRE(std::abs(d) == 1);
+  }
+}
@@ -0,0 +1,235 @@
+#include <libcosy/shard.hpp>
+
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+namespace {
+  template<class T>
+  void put_(Transport::Buffer& buf, const T& val) {
+    auto pos = buf.size();
+    buf.resize(pos + sizeof(T));
+    std::memcpy(buf.data() + pos, &val, sizeof(T));
+  }
+
+  template<class T>
+  auto take_(const char*& pos) ->T {
+    T val;
+    std::memcpy(&val, pos, sizeof(T));
+    pos += sizeof(T);
+    return val;
+  }
+
+  void putSet_(Transport::Buffer& buf, const ActorSet& set) {
+    set.encode(buf);
+  }
+
+  auto takeSet_(const char*& pos, const char* end) ->ActorSet {
+    size_t consumed;
+    auto set = ActorSet::decode(std::span(pos, end), &consumed);
+    pos += consumed;
+    return set;
+  }
+
+  auto checkedMap_(ShardMap map, const Transport& transport) ->ShardMap {
+    if (map.size() != transport.size())
+      throw std::invalid_argument("shard map and transport differ in size");
+    return map;
+  }
+
+  void checkRemaining_(const char* pos, const char* end, uint64_t size, int peer) {
+    if (size > uint64_t(end - pos)) throw std::invalid_argument(std::format("truncated exchange from rank {}", peer));
+  }
+}
+
+ShardMap::ShardMap(std::vector<ActorSet> shards): shards_(std::move(shards)) {
+  for (int rank = 0; rank < int(shards_.size()); ++rank) {
+    for (const auto& seg: shards_[rank].segments())
+      ranges_.push_back({.first = seg.first, .last = seg.second, .rank = rank});
+  }
+  ranges::sort(ranges_, {}, &Range_::first);
+  for (size_t i = 1; i < ranges_.size(); ++i) {
+    if (ranges_[i].first <= ranges_[i - 1].last)
+      throw std::invalid_argument("shards must be disjoint");
+  }
+}
+
+auto ShardMap::partition(ActorSet ids, int n) ->ShardMap {
+  if (n < 1) throw std::invalid_argument("at least one shard is needed");
+  auto total = ids.size();
+  std::vector<ActorSet> shards;
+  for (int rank = 0; rank < n; ++rank) {
+    auto num = total / n + (uint64_t(rank) < total % n? 1 : 0);
+    shards.push_back(ids.takeHead(num));
+  }
+  return ShardMap(std::move(shards));
+}
+
+auto ShardMap::size() const ->int {
+  return shards_.size();
+}
+
+auto ShardMap::shard(int rank) const ->const ActorSet& {
+  return shards_.at(rank);
+}
+
+auto ShardMap::owner(ActorId id) const ->int {
+  auto it = ranges::upper_bound(ranges_, id, {}, &Range_::first);
+  if (it == ranges_.begin()) return -1;
+  --it;
+  return id <= it->last? it->rank : -1;
+}
+
+Shard::Shard(ActorType* type, ShardMap map, Transport& transport):
+  map_(checkedMap_(std::move(map), transport)),
+  transport_(transport),
+  table_(type, std::make_shared<ActorSet>(map_.shard(transport.rank()))),
+  ghosts_(type, std::make_shared<ActorSet>()),
+  imports_(transport.size()),
+  exports_(transport.size()),
+  outbox_(transport.size()) {
+  auto num_actors = map_.shard(transport.rank()).size();
+  if (num_actors > uint64_t(std::numeric_limits<int>::max()))
+    throw std::invalid_argument(std::format("shard of {} actors is too large", num_actors));
+  table_.newActors(int(num_actors));
+  for (const auto& attr: type->attributes()) {
+    if (attr.cold)   cold_.push_back(&attr);
+    if (attr.column) columns_.push_back(&attr);
+  }
+}
+
+auto Shard::rank() const ->int {
+  return transport_.rank();
+}
+
+auto Shard::map() const ->const ShardMap& {
+  return map_;
+}
+
+auto Shard::table() ->Table& {
+  return table_;
+}
+
+auto Shard::ghosts() ->Table& {
+  return ghosts_;
+}
+
+void Shard::setGhosts(const ActorSet& ids) {
+  std::vector<ActorSet> imports(transport_.size());
+  ids.forEach([&](ActorId id) {
+    auto owner = map_.owner(id);
+    if (owner < 0 || owner == rank())
+      throw std::invalid_argument(std::format("actor {} is not owned by another shard", id));
+    imports[owner].insert(id);
+  });
+
+  std::vector<Transport::Buffer> requests(transport_.size());
+  for (int peer = 0; peer < transport_.size(); ++peer) putSet_(requests[peer], imports[peer]);
+  auto received = transport_.exchange(std::move(requests));
+  for (int peer = 0; peer < transport_.size(); ++peer) {
+    const char* pos = received[peer].data();
+    exports_[peer] = peer == rank()? ActorSet{} : takeSet_(pos, pos + received[peer].size());
+  }
+
+  for (const auto& set: imports_) ghosts_.extractActors(set);
+  imports_ = std::move(imports);
+  for (const auto& set: imports_) ghosts_.insertActors(set);
+}
+
+void Shard::post(ActorId to, std::span<const char> payload) {
+  auto owner = map_.owner(to);
+  if (owner < 0) throw std::invalid_argument(std::format("actor {} is not owned by any shard", to));
+  auto& buf = outbox_[owner];
+  put_<ActorId>(buf, to);
+  put_<uint64_t>(buf, payload.size());
+  buf.insert(buf.end(), payload.begin(), payload.end());
+}
+
+// Each buffer holds the ghosts, in id order, followed by the messages. A
+// ghost is its record, its buffered record, its cold values and its
+// column values. Sizes sent by peers are checked against the buffer
+// before anything is read.
+void Shard::exchange() {
+  std::vector<Transport::Buffer> out(transport_.size());
+  for (int peer = 0; peer < transport_.size(); ++peer) {
+    packRecords_(exports_[peer], out[peer]);
+    out[peer].insert(out[peer].end(), outbox_[peer].begin(), outbox_[peer].end());
+    outbox_[peer].clear();
+  }
+  auto in = transport_.exchange(std::move(out));
+
+  inbox_.clear();
+  for (int peer = 0; peer < transport_.size(); ++peer) {
+    const char* pos = in[peer].data();
+    const char* end = pos + in[peer].size();
+    checkRemaining_(pos, end, imports_[peer].size() * ghostSize_(), peer);
+    unpackRecords_(imports_[peer], pos);
+    while (pos < end) {
+      checkRemaining_(pos, end, sizeof(ActorId) + sizeof(uint64_t), peer);
+      auto to   = take_<ActorId>(pos);
+      auto size = take_<uint64_t>(pos);
+      checkRemaining_(pos, end, size, peer);
+      inbox_.push_back({.to = to, .payload = std::vector<char>(pos, pos + size)});
+      pos += size;
+    }
+  }
+}
+
+auto Shard::inbox() const ->const std::vector<Message>& {
+  return inbox_;
+}
+
+auto Shard::ghostSize_() const ->size_t {
+  auto size = table_.type()->size() + table_.type()->bufferedSize();
+  for (auto attr: cold_)    size += attr->type->size();
+  for (auto attr: columns_) size += attr->type->size();
+  return size;
+}
+
+void Shard::packRecords_(const ActorSet& ids, Transport::Buffer& buf) {
+  auto size  = table_.type()->size();
+  auto bsize = table_.type()->bufferedSize();
+  buf.reserve(buf.size() + ids.size() * ghostSize_());
+  ids.forEach([&](ActorId id) {
+    auto rec = table_.record(id);
+    buf.insert(buf.end(), rec, rec + size);
+    if (bsize > 0) {
+      auto brec = table_.bufferedRecord(id);
+      buf.insert(buf.end(), brec, brec + bsize);
+    }
+    auto slot = table_.slot(id);
+    for (auto attr: cold_) {
+      auto pos = buf.size();
+      buf.resize(pos + attr->type->size());
+      table_.cold(*attr).get(slot, buf.data() + pos);
+    }
+    for (auto attr: columns_) {
+      auto pos = buf.size();
+      buf.resize(pos + attr->type->size());
+      table_.getColumnValue(*attr, slot, buf.data() + pos);
+    }
+  });
+}
+
+void Shard::unpackRecords_(const ActorSet& ids, const char*& pos) {
+  auto size  = ghosts_.type()->size();
+  auto bsize = ghosts_.type()->bufferedSize();
+  ids.forEach([&](ActorId id) {
+    if (size > 0) std::memcpy(ghosts_.record(id), pos, size);
+    pos += size;
+    if (bsize > 0) {
+      std::memcpy(ghosts_.bufferedRecord(id), pos, bsize);
+      pos += bsize;
+    }
+    auto slot = ghosts_.slot(id);
+    for (auto attr: cold_) {
+      ghosts_.cold(*attr).set(slot, pos);
+      pos += attr->type->size();
+    }
+    for (auto attr: columns_) {
+      ghosts_.setColumnValue(*attr, slot, pos);
+      pos += attr->type->size();
+    }
+  });
+  for (auto attr: cold_) ghosts_.cold(*attr).flush();
+}
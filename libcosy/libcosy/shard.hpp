@@ -0,0 +1,87 @@
+#ifndef shard_hpp_INCLUDED
+#define shard_hpp_INCLUDED
+
+#include <libcosy/table.hpp>
+#include <libcosy/transport.hpp>
+
+#include <span>
+#include <vector>
+
+// Assignment of actor ids to shards. Each shard owns a set of id segments.
+class ShardMap {
+public:
+
+  ShardMap(std::vector<ActorSet> shards);
+
+  // Splits ids into n shards of consecutive ids and equal size.
+  static auto partition(ActorSet ids, int n) ->ShardMap;
+
+  auto size() const ->int;
+  auto shard(int rank) const ->const ActorSet&;
+
+  // Returns the rank owning id, or -1 if no shard does.
+  auto owner(ActorId id) const ->int;
+
+private:
+
+  struct Range_ {
+    ActorId first,
+            last;
+    int     rank;
+  };
+
+  std::vector<ActorSet> shards_;
+  std::vector<Range_>   ranges_;
+};
+
+// The part of a sharded simulation run by one rank. It owns the actors of
+// its shard and keeps ghost copies of the remote actors it reads,
+// refreshed at each exchange. Messages to remote actors are batched per
+// shard until the exchange.
+class Shard {
+public:
+
+  struct Message {
+    ActorId           to;
+    std::vector<char> payload;
+  };
+
+  Shard(ActorType* type, ShardMap map, Transport& transport);
+
+  auto rank() const ->int;
+  auto map() const ->const ShardMap&;
+  auto table() ->Table&;
+  auto ghosts() ->Table&;
+
+  // Declares the remote actors whose records this shard reads. Collective.
+  void setGhosts(const ActorSet& ids);
+
+  // Queues a message to an actor on any shard.
+  void post(ActorId to, std::span<const char> payload);
+
+  // Ends a tick on all ranks: delivers the queued messages and refreshes the
+  // ghosts. Collective.
+  void exchange();
+
+  // The messages delivered to this shard's actors by the last exchange.
+  auto inbox() const ->const std::vector<Message>&;
+
+private:
+
+  auto ghostSize_() const ->size_t;
+  void packRecords_(const ActorSet& ids, Transport::Buffer& buf);
+  void unpackRecords_(const ActorSet& ids, const char*& pos);
+
+  ShardMap                       map_;
+  Transport&                     transport_;
+  Table                          table_;
+  Table                          ghosts_;
+  std::vector<ActorSet>          imports_; // ghosts, per owning rank
+  std::vector<ActorSet>          exports_; // own actors ghosted, per rank
+  std::vector<Transport::Buffer> outbox_;
+  std::vector<Message>           inbox_;
+  std::vector<const Attribute*>  cold_;
+  std::vector<const Attribute*>  columns_;
+};
+
+#endif // shard_hpp_INCLUDED
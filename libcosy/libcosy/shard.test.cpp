@@ -0,0 +1,138 @@
+#include <libcosy/mock/attribute_type.hpp>
+#include <libcosy/shard.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstring>
+#include <thread>
+#include <unistd.h>
+
+TEST_CASE("ShardMap", "[Shard]") {
+  auto map = ShardMap::partition(ActorSet{{1, 10}}, 3);
+  REQUIRE(map.size() == 3);
+  REQUIRE(map.shard(0) == ActorSet{{1, 4}});
+  REQUIRE(map.shard(1) == ActorSet{{5, 7}});
+  REQUIRE(map.shard(2) == ActorSet{{8, 10}});
+  REQUIRE(map.owner(1) == 0);
+  REQUIRE(map.owner(7) == 1);
+  REQUIRE(map.owner(10) == 2);
+  REQUIRE(map.owner(11) == -1);
+  REQUIRE_THROWS_AS(ShardMap({ActorSet{{1, 5}}, ActorSet{{5, 6}}}), std::invalid_argument);
+}
+
+namespace {
+  // Every actor reads its successor on a ring of actors and gets a message
+  // from its predecessor.
+  void ringTick_(Shard& shard, const Attribute& attr, ActorId num_actors, int tick) {
+    auto& table = shard.table();
+    for (uint64_t slot = 0; slot < table.numActors(); ++slot) {
+      ActorId id = table.actorAt(slot);
+      table.field(attr).set<uint64_t>(slot, id * 100 + tick);
+    }
+    shard.setGhosts(shard.map().shard(shard.rank()).size() == num_actors
+      ? ActorSet{}
+      : ActorSet{shard.map().shard(shard.rank()).segments().back().second % num_actors + 1});
+    for (uint64_t slot = 0; slot < table.numActors(); ++slot) {
+      ActorId id = table.actorAt(slot);
+      shard.post(id % num_actors + 1, std::span(reinterpret_cast<const char*>(&id), sizeof(id)));
+    }
+    shard.exchange();
+  }
+}
+
+TEST_CASE("Shard: local transport", "[Shard]") {
+  AttributeTypeMock atm {"type mock", 8, 8};
+  ActorType type("node", RecordType{Attribute{.name = "val", .type = &atm}});
+  auto& attr = *type.attribute("val");
+  constexpr ActorId num_actors = 10;
+  constexpr int     num_shards = 3;
+
+  auto map        = ShardMap::partition(ActorSet{{1, num_actors}}, num_shards);
+  auto transports = LocalTransport::create(num_shards);
+  std::vector<std::vector<Shard::Message>> inboxes(num_shards);
+  std::vector<uint64_t>                    ghost_vals(num_shards);
+  auto smaller = ShardMap::partition(ActorSet{{1, num_actors}}, num_shards - 1);
+  REQUIRE_THROWS_AS(Shard(&type, smaller, *transports[num_shards - 1]), std::invalid_argument);
+  {
+    std::vector<std::jthread> threads;
+    for (int rank = 0; rank < num_shards; ++rank) {
+      threads.emplace_back([&, rank] {
+        Shard shard(&type, map, *transports[rank]);
+        for (int tick = 0; tick < 3; ++tick) ringTick_(shard, attr, num_actors, tick);
+        inboxes[rank] = shard.inbox();
+        auto ghost = shard.map().shard(rank).segments().back().second % num_actors + 1;
+        ghost_vals[rank] = shard.ghosts().field(attr).get<uint64_t>(shard.ghosts().slot(ghost));
+      });
+    }
+  }
+
+  REQUIRE(ghost_vals == std::vector<uint64_t>{502, 802, 102});
+  for (int rank = 0; rank < num_shards; ++rank) {
+    REQUIRE(inboxes[rank].size() == map.shard(rank).size());
+    for (const auto& msg: inboxes[rank]) {
+      ActorId from;
+      std::memcpy(&from, msg.payload.data(), sizeof(from));
+      REQUIRE(map.owner(msg.to) == rank);
+      REQUIRE(msg.to == from % num_actors + 1);
+    }
+  }
+}
+
+TEST_CASE("Shard: ghosts of cold and column attributes", "[Shard]") {
+  AttributeTypeMock atm {"type mock", 4, 4};
+  ActorType type("node", RecordType{
+    Attribute{.name = "val", .type = &atm},
+    Attribute{.name = "tag", .type = &atm, .cold = true},
+    Attribute{.name = "pos", .type = TypeRegistry::global().get("vec2"), .column = true},
+  });
+  auto& tag = *type.attribute("tag");
+  auto& pos = *type.attribute("pos");
+
+  auto map        = ShardMap::partition(ActorSet{{1, 4}}, 2);
+  auto transports = LocalTransport::create(2);
+  std::vector<uint32_t> ghost_tags(2);
+  std::vector<float>    ghost_ys(2);
+  {
+    std::vector<std::jthread> threads;
+    for (int rank = 0; rank < 2; ++rank) {
+      threads.emplace_back([&, rank] {
+        Shard shard(&type, map, *transports[rank]);
+        auto& table = shard.table();
+        for (uint64_t slot = 0; slot < table.numActors(); ++slot) {
+          uint32_t val = table.actorAt(slot) * 10;
+          table.cold(tag).set(slot, reinterpret_cast<const char*>(&val));
+          table.column<float>(pos).lane(1)[slot] = float(val + 1);
+        }
+        ActorId ghost = rank == 0? 3 : 2;
+        shard.setGhosts(ActorSet{ghost});
+        shard.exchange();
+        shard.ghosts().cold(tag).get(shard.ghosts().slot(ghost), reinterpret_cast<char*>(&ghost_tags[rank]));
+        ghost_ys[rank] = shard.ghosts().column<float>(pos).lane(1)[shard.ghosts().slot(ghost)];
+      });
+    }
+  }
+  REQUIRE(ghost_tags == std::vector<uint32_t>{30, 20});
+  REQUIRE(ghost_ys == std::vector<float>{31, 21});
+}
+
+TEST_CASE("UnixSocketTransport", "[Shard]") {
+  auto transport = UnixSocketTransport::fork(3);
+  // Children must not unwind into Catch, so their result is their exit
+  // code, collected by rank 0.
+  bool ok = true;
+  try {
+    std::vector<Transport::Buffer> out(3);
+    for (int peer = 0; peer < 3; ++peer)
+      out[peer] = Transport::Buffer(100'000 * (peer + 1), char('a' + transport->rank()));
+    auto in = transport->exchange(std::move(out));
+    for (int peer = 0; peer < 3; ++peer) {
+      ok = ok && in[peer].size() == size_t(100'000 * (transport->rank() + 1));
+      ok = ok && in[peer].back() == char('a' + peer);
+    }
+  } catch (...) {
+    ok = false;
+  }
+  if (transport->rank() != 0) _exit(ok? 0 : 1);
+  REQUIRE(transport->wait() == std::vector<int>{0, 0});
+  REQUIRE(ok);
+}
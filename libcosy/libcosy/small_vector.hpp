@@ -0,0 +1,181 @@
+#ifndef small_vector_hpp_INCLUDED
+#define small_vector_hpp_INCLUDED
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// A vector holding up to N elements inline, without allocating. Elements
+// are never destroyed, so they have to be trivially destructible, and are
+// copied without throwing, so that moves never throw either and containers
+// of SmallVectors move them when they reallocate. Iterators are plain
+// pointers.
+template<class T, size_t N>
+requires std::is_trivially_destructible_v<T> && std::is_nothrow_copy_constructible_v<T>
+class SmallVector {
+public:
+
+  using value_type     = T;
+  using iterator       = T*;
+  using const_iterator = const T*;
+
+  SmallVector() = default;
+
+  SmallVector(const SmallVector& other) {
+    reserve(other.size_);
+    copy_(data_, other.data_, other.size_);
+    size_ = other.size_;
+  }
+
+  SmallVector(SmallVector&& other) noexcept {
+    take_(other);
+  }
+
+  ~SmallVector() {
+    if (data_ != inline_()) ::operator delete(data_, std::align_val_t(alignof(T)));
+  }
+
+  auto operator = (const SmallVector& other) ->SmallVector& {
+    if (this == &other) return *this;
+    size_ = 0;
+    reserve(other.size_);
+    copy_(data_, other.data_, other.size_);
+    size_ = other.size_;
+    return *this;
+  }
+
+  auto operator = (SmallVector&& other) noexcept ->SmallVector& {
+    if (this == &other) return *this;
+    if (data_ != inline_()) ::operator delete(data_, std::align_val_t(alignof(T)));
+    take_(other);
+    return *this;
+  }
+
+  auto size() const ->size_t      { return size_; }
+  auto empty() const ->bool       { return size_ == 0; }
+  auto capacity() const ->size_t  { return capacity_; }
+  auto data() ->T*                { return data_; }
+  auto data() const ->const T*    { return data_; }
+
+  auto begin() ->T*               { return data_; }
+  auto end() ->T*                 { return data_ + size_; }
+  auto begin() const ->const T*   { return data_; }
+  auto end() const ->const T*     { return data_ + size_; }
+
+  auto front() ->T&               { return data_[0]; }
+  auto front() const ->const T&   { return data_[0]; }
+  auto back() ->T&                { return data_[size_ - 1]; }
+  auto back() const ->const T&    { return data_[size_ - 1]; }
+
+  auto operator [] (size_t idx) ->T&             { return data_[idx]; }
+  auto operator [] (size_t idx) const ->const T& { return data_[idx]; }
+
+  void reserve(size_t capacity) {
+    if (capacity <= capacity_) return;
+    auto data = static_cast<T*>(::operator new(capacity * sizeof(T), std::align_val_t(alignof(T))));
+    copy_(data, data_, size_);
+    if (data_ != inline_()) ::operator delete(data_, std::align_val_t(alignof(T)));
+    data_     = data;
+    capacity_ = capacity;
+  }
+
+  // New elements are value initialized.
+  void resize(size_t size) {
+    grow_(size);
+    for (auto i = size_; i < size; ++i) std::construct_at(data_ + i);
+    size_ = size;
+  }
+
+  void clear() {
+    size_ = 0;
+  }
+
+  template<class... Args>
+  auto emplace_back(Args&&... args) ->T& {
+    grow_(size_ + 1);
+    std::construct_at(data_ + size_, std::forward<Args>(args)...);
+    return data_[size_++];
+  }
+
+  void push_back(const T& val) {
+    emplace_back(val);
+  }
+
+  void pop_back() {
+    --size_;
+  }
+
+  template<class... Args>
+  auto emplace(const T* pos, Args&&... args) ->T* {
+    T val(std::forward<Args>(args)...);
+    auto idx = pos - data_;
+    grow_(size_ + 1);
+    if (idx == ptrdiff_t(size_)) {
+      std::construct_at(data_ + idx, val);
+    } else {
+      std::construct_at(data_ + size_, data_[size_ - 1]);
+      std::move_backward(data_ + idx, data_ + size_ - 1, data_ + size_);
+      data_[idx] = val;
+    }
+    ++size_;
+    return data_ + idx;
+  }
+
+  auto insert(const T* pos, const T& val) ->T* {
+    return emplace(pos, val);
+  }
+
+  auto erase(const T* pos) ->T* {
+    return erase(pos, pos + 1);
+  }
+
+  auto erase(const T* first, const T* last) ->T* {
+    auto idx = first - data_;
+    std::move(data_ + (last - data_), end(), data_ + idx);
+    size_ -= last - first;
+    return data_ + idx;
+  }
+
+  friend auto operator == (const SmallVector& a, const SmallVector& b) ->bool {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end());
+  }
+
+private:
+
+  static void copy_(T* to, const T* from, size_t n) {
+    std::uninitialized_copy_n(from, n, to);
+  }
+
+  void grow_(size_t size) {
+    if (size > capacity_) reserve(std::max(size, 2 * capacity_));
+  }
+
+  void take_(SmallVector& other) {
+    if (other.data_ == other.inline_()) {
+      data_     = inline_();
+      capacity_ = N;
+      copy_(data_, other.data_, other.size_);
+    } else {
+      data_     = other.data_;
+      capacity_ = other.capacity_;
+    }
+    size_ = other.size_;
+    other.data_     = other.inline_();
+    other.size_     = 0;
+    other.capacity_ = N;
+  }
+
+  auto inline_() ->T* {
+    return reinterpret_cast<T*>(storage_);
+  }
+
+  alignas(T) std::byte storage_[N * sizeof(T)];
+  T*                   data_     = inline_();
+  size_t               size_     = 0;
+  size_t               capacity_ = N;
+};
+
+#endif // small_vector_hpp_INCLUDED
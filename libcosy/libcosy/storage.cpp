@@ -0,0 +1,213 @@
+#include <libcosy/storage.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#ifdef __linux__
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+namespace {
+  constexpr size_t cache_line_size_ = 64;
+  constexpr size_t huge_page_size_  = 2 << 20;
+
+  // From linux/mempolicy.h, which is not installed everywhere.
+  constexpr int mpol_bind_       = 2;
+  constexpr int mpol_interleave_ = 3;
+  constexpr int mpol_mf_move_    = 1 << 1;
+
+  auto roundUp_(size_t n, size_t multiple) ->size_t {
+    return ((n + multiple - 1) / multiple) * multiple;
+  }
+
+  // Node masks hold one bit per node in an unsigned long, which
+  // numNumaNodes() never exceeds.
+  auto nodeMask_(int node) ->unsigned long {
+    if (node < 0 || node >= numNumaNodes()) throw std::invalid_argument(std::format("no NUMA node {}", node));
+    return 1ul << node;
+  }
+
+#ifdef __linux__
+  auto allNodesMask_() ->unsigned long {
+    auto nodes = numNumaNodes();
+    return nodes >= 64? ~0ul : (1ul << nodes) - 1;
+  }
+
+  auto mbind_(void* ptr, size_t size, int mode, unsigned long mask, unsigned flags) ->bool {
+    auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    auto addr = reinterpret_cast<uintptr_t>(ptr);
+    auto from = addr / page * page;
+    return syscall(SYS_mbind, from, roundUp_(addr + size, page) - from, mode, &mask, 64, flags) == 0;
+  }
+#endif
+}
+
+auto HeapAllocator::allocate(size_t size) ->void* {
+  return ::operator new(size, std::align_val_t(cache_line_size_));
+}
+
+void HeapAllocator::deallocate(void* ptr, size_t /*size*/) {
+  ::operator delete(ptr, std::align_val_t(cache_line_size_));
+}
+
+MmapAllocator::MmapAllocator(HugePages huge_pages, NumaPolicy policy, int node):
+  huge_pages_(huge_pages),
+  policy_(policy),
+  node_(node) {
+  if (policy == NumaPolicy::node) nodeMask_(node);
+}
+
+auto MmapAllocator::allocate(size_t size) ->void* {
+#ifdef __linux__
+  auto len   = mappedSize_(size);
+  auto flags = MAP_PRIVATE | MAP_ANONYMOUS;
+  void* ptr  = MAP_FAILED;
+  // Without MAP_NORESERVE the mapping fails up front, instead of faulting
+  // later, when not enough huge pages are reserved.
+  if (huge_pages_ == HugePages::reserved)
+    ptr = mmap(nullptr, len, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1, 0);
+  if (ptr == MAP_FAILED) {
+    ptr = mmap(nullptr, len, PROT_READ | PROT_WRITE, flags | MAP_NORESERVE, -1, 0);
+    if (ptr == MAP_FAILED) throw std::bad_alloc();
+    if (huge_pages_ != HugePages::none) madvise(ptr, len, MADV_HUGEPAGE);
+  }
+  // The policy has to be set before the pages are first touched.
+  bool bound = true;
+  switch (policy_) {
+  case NumaPolicy::none:
+    break;
+  case NumaPolicy::local: {
+    auto node = currentNumaNode();
+    bound = node < numNumaNodes() && mbind_(ptr, len, mpol_bind_, nodeMask_(node), 0);
+    break;
+  }
+  case NumaPolicy::node:
+    bound = mbind_(ptr, len, mpol_bind_, nodeMask_(node_), 0);
+    break;
+  case NumaPolicy::interleave:
+    bound = mbind_(ptr, len, mpol_interleave_, allNodesMask_(), 0);
+    break;
+  }
+  if (!bound) ++failed_placements_;
+  return ptr;
+#else
+  return HeapAllocator().allocate(size);
+#endif
+}
+
+void MmapAllocator::deallocate(void* ptr, size_t size) {
+#ifdef __linux__
+  munmap(ptr, mappedSize_(size));
+#else
+  HeapAllocator().deallocate(ptr, size);
+#endif
+}
+
+void MmapAllocator::place(void* ptr, size_t size, int node) {
+#ifdef __linux__
+  if (!mbind_(ptr, size, mpol_bind_, nodeMask_(node), mpol_mf_move_)) ++failed_placements_;
+#else
+  nodeMask_(node);
+#endif
+}
+
+auto MmapAllocator::failedPlacements() const ->uint64_t {
+  return failed_placements_;
+}
+
+auto MmapAllocator::zeroed() const ->bool {
+#ifdef __linux__
+  return true;
+#else
+  return false;
+#endif
+}
+
+auto MmapAllocator::mappedSize_(size_t size) const ->size_t {
+  return huge_pages_ == HugePages::none? size : roundUp_(size, huge_page_size_);
+}
+
+auto defaultAllocator() ->std::shared_ptr<StorageAllocator> {
+  static auto allocator = std::make_shared<HeapAllocator>();
+  return allocator;
+}
+
+auto currentNumaNode() ->int {
+#ifdef __linux__
+  unsigned cpu, node;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) return node;
+#endif
+  return 0;
+}
+
+auto numNumaNodes() ->int {
+  static int nodes = [] {
+    // The online mask is a range list such as "0" or "0-1".
+    std::ifstream file("/sys/devices/system/node/online");
+    std::string mask;
+    if (!(file >> mask)) return 1;
+    auto last = mask.find_last_of("-,");
+    auto max  = std::stoi(last == std::string::npos? mask : mask.substr(last + 1));
+    return std::clamp(max + 1, 1, 64);
+  }();
+  return nodes;
+}
+
+Storage::Storage(std::shared_ptr<StorageAllocator> allocator):
+  allocator_(std::move(allocator)) {}
+
+Storage::~Storage() {
+  if (data_ != nullptr) allocator_->deallocate(data_, size_);
+}
+
+Storage::Storage(Storage&& other):
+  allocator_(other.allocator_),
+  data_(std::exchange(other.data_, nullptr)),
+  size_(std::exchange(other.size_, 0)) {}
+
+auto Storage::operator = (Storage&& other) ->Storage& {
+  std::swap(allocator_, other.allocator_);
+  std::swap(data_, other.data_);
+  std::swap(size_, other.size_);
+  return *this;
+}
+
+void Storage::resize(size_t size) {
+  resize(size, size_);
+}
+
+void Storage::resize(size_t size, size_t keep) {
+  if (size == size_) return;
+  char* data = size > 0? static_cast<char*>(allocator_->allocate(size)) : nullptr;
+  if (data_ != nullptr) {
+    if (auto n = std::min({size, size_, keep}); n > 0) std::memcpy(data, data_, n);
+    allocator_->deallocate(data_, size_);
+  }
+  data_ = data;
+  size_ = size;
+}
+
+auto Storage::data() const ->char* {
+  return data_;
+}
+
+auto Storage::size() const ->size_t {
+  return size_;
+}
+
+auto Storage::allocator() const ->StorageAllocator& {
+  return *allocator_;
+}
+
+auto Storage::allocatorPtr() const ->std::shared_ptr<StorageAllocator> {
+  return allocator_;
+}
@@ -0,0 +1,107 @@
+#ifndef storage_hpp_INCLUDED
+#define storage_hpp_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+class StorageAllocator {
+public:
+
+  virtual ~StorageAllocator() = default;
+
+  virtual auto allocate(size_t size) ->void* = 0;
+  virtual void deallocate(void* ptr, size_t size) = 0;
+
+  // Moves the pages of [ptr, ptr + size) to the given NUMA node. Allocators
+  // without NUMA support ignore this.
+  virtual void place(void* /*ptr*/, size_t /*size*/, int /*node*/) {}
+
+  // Whether fresh allocations read as zero, so that users can leave them
+  // untouched until the thread that will use them first writes them.
+  virtual auto zeroed() const ->bool { return false; }
+};
+
+class HeapAllocator: public StorageAllocator {
+public:
+
+  auto allocate(size_t size) ->void* override;
+  void deallocate(void* ptr, size_t size) override;
+};
+
+enum class HugePages {
+  none,
+  transparent, // madvise(MADV_HUGEPAGE)
+  reserved,    // MAP_HUGETLB, falling back to transparent if none are reserved
+};
+
+enum class NumaPolicy {
+  none,       // first touch
+  local,      // bind to the node of the allocating thread
+  node,       // bind to a fixed node
+  interleave, // interleave pages over all nodes
+};
+
+class MmapAllocator: public StorageAllocator {
+public:
+
+  // Nodes outside [0, numNumaNodes()) throw std::invalid_argument, here
+  // and in place().
+  MmapAllocator(HugePages huge_pages, NumaPolicy policy = NumaPolicy::none, int node = 0);
+
+  auto allocate(size_t size) ->void* override;
+  void deallocate(void* ptr, size_t size) override;
+  void place(void* ptr, size_t size, int node) override;
+  auto zeroed() const ->bool override;
+
+  // The number of allocations and placements whose NUMA binding the kernel
+  // refused. Their pages stay wherever first touch puts them.
+  auto failedPlacements() const ->uint64_t;
+
+private:
+
+  auto mappedSize_(size_t size) const ->size_t;
+
+  HugePages             huge_pages_;
+  NumaPolicy            policy_;
+  int                   node_;
+  std::atomic<uint64_t> failed_placements_ = 0;
+};
+
+auto defaultAllocator() ->std::shared_ptr<StorageAllocator>;
+
+auto currentNumaNode() ->int;
+auto numNumaNodes() ->int;
+
+// A growable untyped buffer backed by a StorageAllocator. Unlike
+// std::vector it never initializes memory.
+class Storage {
+public:
+
+  Storage(std::shared_ptr<StorageAllocator> allocator);
+  ~Storage();
+
+  Storage(const Storage&) = delete;
+  auto operator = (const Storage&) ->Storage& = delete;
+  Storage(Storage&&);
+  auto operator = (Storage&&) ->Storage&;
+
+  // Reallocating copies the first keep bytes only, leaving the rest of
+  // the new memory untouched.
+  void resize(size_t size);
+  void resize(size_t size, size_t keep);
+
+  auto data() const ->char*;
+  auto size() const ->size_t;
+  auto allocator() const ->StorageAllocator&;
+  auto allocatorPtr() const ->std::shared_ptr<StorageAllocator>;
+
+private:
+
+  std::shared_ptr<StorageAllocator> allocator_;
+  char*                             data_ = nullptr;
+  size_t                            size_ = 0;
+};
+
+#endif // storage_hpp_INCLUDED
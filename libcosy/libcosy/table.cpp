@@ -1,6 +1,10 @@
 #include <libcosy/table.hpp>
+#include <libcosy/parallel.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <numeric>
 
 namespace {
   auto smallestGreaterPow2_(uint64_t n) ->uint64_t {
@@ -8,38 +12,459 @@ namespace {
     while (res < n) res <<= 1;
     return res;
   }
+
+  constexpr uint64_t min_slots_per_thread_ = 1 << 14;
 }
 
 auto Table::newActor() ->ActorId {
   ++num_actors_;
   resizeBuffer_();
-  return available_ids_.takeHead();
+  auto id = available_ids_->takeHead();
+  appendSlot_(id);
+  return id;
 }
 
 auto Table::newActors(int n) ->ActorSet {
   num_actors_ += n;
   resizeBuffer_();
-  return available_ids_.takeHead(n);
+  auto ids = available_ids_->takeHead(n);
+  ids.forEach([this](ActorId id) { appendSlot_(id); });
+  return ids;
 }
 
 void Table::deleteActor(ActorId id) {
-  assert(!available_ids_.contains(id));
+  assert(!available_ids_->contains(id));
+  ColdMoves_ moves;
+  removeSlot_(id, moves);
+  compactCold_(moves);
   --num_actors_;
-  available_ids_.insert(id);
+  available_ids_->insert(id);
 }
 
 void Table::deleteActors(const ActorSet& ids) {
-  assert(available_ids_.intersect(ids).size() == 0);
+  assert(available_ids_->intersect(ids).size() == 0);
+  ColdMoves_ moves;
+  ids.forEach([&](ActorId id) { removeSlot_(id, moves); });
+  compactCold_(moves);
   num_actors_ -= ids.size();
-  available_ids_.merge(ids);
+  available_ids_->merge(ids);
+}
+
+void Table::insertActors(const ActorSet& ids) {
+  num_actors_ += ids.size();
+  resizeBuffer_();
+  ids.forEach([this](ActorId id) { appendSlot_(id); });
 }
 
-auto Table::numActors() ->uint64_t {
+void Table::extractActors(const ActorSet& ids) {
+  ColdMoves_ moves;
+  ids.forEach([&](ActorId id) { removeSlot_(id, moves); });
+  compactCold_(moves);
+  num_actors_ -= ids.size();
+}
+
+auto Table::numActors() const ->uint64_t {
   return num_actors_;
 }
 
+auto Table::contains(ActorId id) const ->bool {
+  return slots_.contains(id);
+}
+
+auto Table::layoutVersion() const ->uint64_t {
+  return layout_version_;
+}
+
+auto Table::addedVersions() const ->std::span<const uint64_t> {
+  return slot_added_;
+}
+
+auto Table::type() const ->ActorType* {
+  return type_;
+}
+
+auto Table::slot(ActorId id) const ->uint64_t {
+  auto it = slots_.find(id);
+  if (it == slots_.end()) throw std::out_of_range(std::format("no actor with id {}", id));
+  return it->second;
+}
+
+auto Table::actorAt(uint64_t slot) const ->ActorId {
+  return slot_ids_.at(slot);
+}
+
+auto Table::record(ActorId id) ->char* {
+  return buffer_.data() + slot(id) * type_->size();
+}
+
+auto Table::data() ->char* {
+  return buffer_.data();
+}
+
+auto Table::field(const Attribute& attr) ->FieldView {
+  if (attr.double_buffered || attr.cold || attr.column)
+    throw std::invalid_argument(std::format("attribute '{}' is not stored in the record", attr.name));
+  return FieldView(buffer_.data() + attr.offset, type_->size());
+}
+
+auto Table::current(const Attribute& attr) const ->ConstFieldView {
+  if (!attr.double_buffered)
+    throw std::invalid_argument(std::format("attribute '{}' is not double-buffered", attr.name));
+  return ConstFieldView(current_.data() + attr.offset, type_->bufferedSize());
+}
+
+auto Table::next(const Attribute& attr) ->FieldView {
+  if (!attr.double_buffered)
+    throw std::invalid_argument(std::format("attribute '{}' is not double-buffered", attr.name));
+  return FieldView(next_.data() + attr.offset, type_->bufferedSize());
+}
+
+void Table::swapBuffers() {
+  std::swap(current_, next_);
+}
+
+auto Table::cold(const Attribute& attr) ->ColdColumn& {
+  if (!attr.cold)
+    throw std::invalid_argument(std::format("attribute '{}' is not cold", attr.name));
+  return cold_[attr.offset];
+}
+
+void Table::getColumnValue(const Attribute& attr, uint64_t slot, char* out) const {
+  if (!attr.column)
+    throw std::invalid_argument(std::format("attribute '{}' is not a column", attr.name));
+  auto [size, lanes] = column_layouts_[attr.offset];
+  auto base = columns_[attr.offset].data();
+  auto stride = columnStride_();
+  for (int k = 0; k < lanes; ++k) std::memcpy(out + k * size, base + (k * stride + slot) * size, size);
+}
+
+void Table::setColumnValue(const Attribute& attr, uint64_t slot, const char* in) {
+  if (!attr.column)
+    throw std::invalid_argument(std::format("attribute '{}' is not a column", attr.name));
+  auto [size, lanes] = column_layouts_[attr.offset];
+  auto base = columns_[attr.offset].data();
+  auto stride = columnStride_();
+  for (int k = 0; k < lanes; ++k) std::memcpy(base + (k * stride + slot) * size, in + k * size, size);
+}
+
+auto Table::bufferedRecord(ActorId id) ->char* {
+  return current_.data() + slot(id) * type_->bufferedSize();
+}
+
+void Table::placeSlots(uint64_t first, uint64_t count, int node) {
+  Placement_ placement{.first = first, .count = count, .node = node};
+  std::erase_if(placements_, [&placement](const Placement_& p) {
+    return p.first >= placement.first && p.first + p.count <= placement.first + placement.count;
+  });
+  placements_.push_back(placement);
+  placeAll_(placement);
+}
+
+void Table::reorder(const std::vector<uint64_t>& order, unsigned threads) {
+  if (order.size() != num_actors_)
+    throw std::invalid_argument("order must have one entry per actor");
+  std::vector<bool> seen(num_actors_);
+  for (auto slot: order) {
+    if (slot >= num_actors_ || seen[slot]) throw std::invalid_argument("order is not a permutation");
+    seen[slot] = true;
+  }
+  auto chunks = numChunks(num_actors_, threads, min_slots_per_thread_);
+
+  // Placements are applied before the copy, so that the pages are first
+  // touched on their node.
+  auto permute = [&](Storage& from, size_t size) {
+    if (size == 0) return;
+    Storage to(from.allocatorPtr());
+    to.resize(from.size());
+    for (const auto& placement: placements_) place_(to, size, 0, 1, placement);
+    forChunks(num_actors_, chunks, [&](unsigned, uint64_t first, uint64_t last) {
+      for (auto slot = first; slot < last; ++slot)
+        std::memcpy(to.data() + slot * size, from.data() + order[slot] * size, size);
+    });
+    from = std::move(to);
+  };
+  permute(buffer_, type_->size());
+  permute(current_, type_->bufferedSize());
+  permute(next_, type_->bufferedSize());
+
+  for (size_t c = 0; c < columns_.size(); ++c) {
+    auto [size, lanes] = column_layouts_[c];
+    auto lane_size = columnStride_() * size;
+    Storage to(columns_[c].allocatorPtr());
+    to.resize(columns_[c].size());
+    for (const auto& placement: placements_) place_(to, size, columnStride_(), lanes, placement);
+    if (!zeroed_) std::memset(to.data(), 0, to.size());
+    for (int k = 0; k < lanes; ++k) {
+      auto from_lane = columns_[c].data() + k * lane_size;
+      auto to_lane   = to.data() + k * lane_size;
+      forChunks(num_actors_, chunks, [&](unsigned, uint64_t first, uint64_t last) {
+        for (auto slot = first; slot < last; ++slot)
+          std::memcpy(to_lane + slot * size, from_lane + order[slot] * size, size);
+      });
+    }
+    columns_[c] = std::move(to);
+  }
+
+  for (auto& column: cold_) {
+    ColdColumn permuted(column.width());
+    permuted.resize(num_actors_);
+    std::vector<char> val(column.width());
+    for (uint64_t slot = 0; slot < num_actors_; ++slot) {
+      column.get(order[slot], val.data());
+      permuted.set(slot, val.data());
+    }
+    permuted.flush();
+    column = std::move(permuted);
+  }
+
+  std::vector<ActorId> slot_ids(num_actors_);
+  std::vector<uint64_t> slot_added(num_actors_);
+  for (uint64_t slot = 0; slot < num_actors_; ++slot) {
+    slot_ids[slot]   = slot_ids_[order[slot]];
+    slot_added[slot] = slot_added_[order[slot]];
+  }
+  slot_ids_   = std::move(slot_ids);
+  slot_added_ = std::move(slot_added);
+  forChunks(num_actors_, chunks, [this](unsigned, uint64_t first, uint64_t last) {
+    for (auto slot = first; slot < last; ++slot) slots_.find(slot_ids_[slot])->second = slot;
+  });
+  ++layout_version_;
+}
+
+void Table::saveState(std::vector<char>& buf) const {
+  auto put = [&buf](const char* data, size_t size) { buf.insert(buf.end(), data, data + size); };
+  available_ids_->encode(buf);
+  put(reinterpret_cast<const char*>(&num_actors_), sizeof(num_actors_));
+  put(reinterpret_cast<const char*>(slot_ids_.data()), num_actors_ * sizeof(ActorId));
+  put(buffer_.data(), num_actors_ * type_->size());
+  put(current_.data(), num_actors_ * type_->bufferedSize());
+  put(next_.data(), num_actors_ * type_->bufferedSize());
+  for (size_t c = 0; c < columns_.size(); ++c) {
+    auto [size, lanes] = column_layouts_[c];
+    for (int k = 0; k < lanes; ++k)
+      put(columns_[c].data() + k * columnStride_() * size, num_actors_ * size);
+  }
+  for (const auto& column: cold_) {
+    auto pos = buf.size();
+    buf.resize(pos + num_actors_ * column.width());
+    column.decode(0, num_actors_, buf.data() + pos);
+  }
+}
+
+// The whole buffer is checked before the table is changed, so that a
+// truncated or malformed state leaves it empty.
+void Table::loadState(std::span<const char> buf) {
+  if (num_actors_ > 0) throw std::logic_error("state can only be loaded into an empty table");
+  size_t consumed;
+  auto pool = ActorSet::decode(buf, &consumed);
+  auto pos = buf.data() + consumed, end = buf.data() + buf.size();
+  auto take = [&pos](char* out, size_t size) {
+    if (size == 0) return;
+    std::memcpy(out, pos, size);
+    pos += size;
+  };
+
+  uint64_t n;
+  if (size_t(end - pos) < sizeof(n)) throw std::invalid_argument("truncated table state");
+  take(reinterpret_cast<char*>(&n), sizeof(n));
+  uint64_t record_size = sizeof(ActorId) + type_->size() + 2 * type_->bufferedSize();
+  for (auto [size, lanes]: column_layouts_) record_size += size * lanes;
+  for (const auto& column: cold_) record_size += column.width();
+  if (n > size_t(end - pos) / record_size) throw std::invalid_argument("truncated table state");
+  std::vector<ActorId> slot_ids(n);
+  take(reinterpret_cast<char*>(slot_ids.data()), n * sizeof(ActorId));
+  std::unordered_map<ActorId, uint64_t> slots;
+  slots.reserve(n);
+  for (uint64_t slot = 0; slot < n; ++slot) {
+    if (!slots.emplace(slot_ids[slot], slot).second || pool.contains(slot_ids[slot]))
+      throw std::invalid_argument(std::format("actor {} is not unique in table state", slot_ids[slot]));
+  }
+
+  *available_ids_ = std::move(pool);
+  num_actors_ = n;
+  resizeBuffer_();
+  slot_ids_ = std::move(slot_ids);
+  slots_    = std::move(slots);
+  slot_added_.resize(n);
+  std::iota(slot_added_.begin(), slot_added_.end(), layout_version_ + 1);
+  layout_version_ += n + 1;
+  touched_ = std::max(touched_, n);
+  take(buffer_.data(), n * type_->size());
+  take(current_.data(), n * type_->bufferedSize());
+  take(next_.data(), n * type_->bufferedSize());
+  for (size_t c = 0; c < columns_.size(); ++c) {
+    auto [size, lanes] = column_layouts_[c];
+    for (int k = 0; k < lanes; ++k)
+      take(columns_[c].data() + k * columnStride_() * size, n * size);
+  }
+  std::vector<char> vals;
+  for (auto& column: cold_) {
+    vals.resize(n * column.width());
+    take(vals.data(), vals.size());
+    column.resize(n);
+    for (uint64_t slot = 0; slot < n; ++slot) column.set(slot, vals.data() + slot * column.width());
+    column.flush();
+  }
+}
+
+void Table::initColumns_(const std::shared_ptr<StorageAllocator>& allocator) {
+  columns_.reserve(type_->numColumnAttributes());
+  column_layouts_.resize(type_->numColumnAttributes());
+  for (size_t c = 0; c < type_->numColumnAttributes(); ++c) columns_.emplace_back(allocator);
+  for (const auto& attr: type_->attributes()) {
+    if (!attr.column) continue;
+    auto primitive = dynamic_cast<PrimitiveType*>(attr.type);
+    column_layouts_[attr.offset] = primitive != nullptr
+      ? ColumnLayout_{.element_size = size_t(primitive->elementSize()), .lanes = primitive->lanes()}
+      : ColumnLayout_{.element_size = size_t(attr.type->size()), .lanes = 1};
+  }
+}
+
+auto Table::column_(const Attribute& attr, size_t element_size) ->ColumnView<char> {
+  if (!attr.column)
+    throw std::invalid_argument(std::format("attribute '{}' is not a column", attr.name));
+  auto [size, lanes] = column_layouts_[attr.offset];
+  if (element_size != size)
+    throw std::invalid_argument(std::format("attribute '{}' has elements of {} bytes", attr.name, size));
+  auto width = column_alignment / std::gcd(column_alignment, size);
+  return ColumnView<char>{
+    .data        = columns_[attr.offset].data(),
+    .size        = num_actors_,
+    .padded_size = (num_actors_ + width - 1) / width * width,
+    .lane_stride = columnStride_(),
+    .lanes       = lanes,
+  };
+}
+
+// Lanes hold a multiple of column_alignment values, which keeps every lane
+// aligned whatever the element size.
+auto Table::columnStride_() const ->uint64_t {
+  return (capacity_ + column_alignment - 1) / column_alignment * column_alignment;
+}
+
+void Table::place_(const Storage& storage, size_t size, uint64_t lane_stride, int lanes, const Placement_& placement) const {
+  auto first = placement.first;
+  auto last  = std::min(placement.first + placement.count, capacity_);
+  if (size == 0 || first >= last) return;
+  for (int k = 0; k < lanes; ++k)
+    storage.allocator().place(storage.data() + (k * lane_stride + first) * size, (last - first) * size, placement.node);
+}
+
+void Table::placeAll_(const Placement_& placement) const {
+  place_(buffer_, type_->size(), 0, 1, placement);
+  place_(current_, type_->bufferedSize(), 0, 1, placement);
+  place_(next_, type_->bufferedSize(), 0, 1, placement);
+  for (size_t c = 0; c < columns_.size(); ++c)
+    place_(columns_[c], column_layouts_[c].element_size, columnStride_(), column_layouts_[c].lanes, placement);
+}
+
+// Lanes move when the stride grows, so columns are copied lane by lane
+// into zeroed storage.
+void Table::resizeColumns_(uint64_t old_stride) {
+  auto stride = columnStride_();
+  if (stride == old_stride) return;
+  auto live = slot_ids_.size();
+  for (size_t c = 0; c < columns_.size(); ++c) {
+    auto [size, lanes] = column_layouts_[c];
+    Storage to(columns_[c].allocatorPtr());
+    to.resize(stride * size * lanes);
+    if (!zeroed_) std::memset(to.data(), 0, to.size());
+    for (int k = 0; k < lanes && live > 0; ++k)
+      std::memcpy(to.data() + k * stride * size, columns_[c].data() + k * old_stride * size, live * size);
+    columns_[c] = std::move(to);
+  }
+}
+
 void Table::resizeBuffer_() {
-  if (type_->size() > 0 && num_actors_ > buffer_.size() / type_->size()) {
-    buffer_.resize(smallestGreaterPow2_(num_actors_) * type_->size());
+  if (num_actors_ <= capacity_) return;
+  auto old_stride = columnStride_();
+  capacity_ = smallestGreaterPow2_(num_actors_);
+  resizeColumns_(old_stride);
+  auto live = slot_ids_.size();
+  buffer_.resize(capacity_ * type_->size(), live * type_->size());
+  if (auto bsize = type_->bufferedSize(); bsize > 0) {
+    current_.resize(capacity_ * bsize, live * bsize);
+    next_.resize(capacity_ * bsize, live * bsize);
+  }
+  for (const auto& placement: placements_) placeAll_(placement);
+}
+
+void Table::appendSlot_(ActorId id) {
+  assert(!slots_.contains(id));
+  auto slot = slot_ids_.size();
+  slots_.emplace(id, slot);
+  slot_ids_.push_back(id);
+  slot_added_.push_back(++layout_version_);
+  for (auto& column: cold_) column.resize(slot + 1);
+  // Zeroed memory is left to be first touched by whoever writes it.
+  auto fresh = zeroed_ && slot >= touched_;
+  touched_ = std::max(touched_, slot + 1);
+  if (fresh) return;
+  if (auto size = type_->size(); size > 0) std::memset(buffer_.data() + slot * size, 0, size);
+  if (auto bsize = type_->bufferedSize(); bsize > 0) {
+    std::memset(current_.data() + slot * bsize, 0, bsize);
+    std::memset(next_.data() + slot * bsize, 0, bsize);
+  }
+  for (size_t c = 0; c < columns_.size(); ++c) {
+    auto [size, lanes] = column_layouts_[c];
+    for (int k = 0; k < lanes; ++k)
+      std::memset(columns_[c].data() + (k * columnStride_() + slot) * size, 0, size);
+  }
+}
+
+// Records are kept densely packed: the last record is moved into the slot
+// being freed. Moves of cold values are only collected, see compactCold_.
+void Table::removeSlot_(ActorId id, ColdMoves_& moves) {
+  auto it = slots_.find(id);
+  assert(it != slots_.end());
+  auto slot = it->second;
+  auto last = slot_ids_.size() - 1;
+  if (slot != last) {
+    if (auto size = type_->size(); size > 0)
+      std::memcpy(buffer_.data() + slot * size, buffer_.data() + last * size, size);
+    if (auto bsize = type_->bufferedSize(); bsize > 0) {
+      std::memcpy(current_.data() + slot * bsize, current_.data() + last * bsize, bsize);
+      std::memcpy(next_.data() + slot * bsize, next_.data() + last * bsize, bsize);
+    }
+    for (size_t c = 0; c < columns_.size(); ++c) {
+      auto [csize, lanes] = column_layouts_[c];
+      for (int k = 0; k < lanes; ++k) {
+        auto lane = columns_[c].data() + k * columnStride_() * csize;
+        std::memcpy(lane + slot * csize, lane + last * csize, csize);
+      }
+    }
+    slot_ids_[slot]   = slot_ids_[last];
+    slot_added_[slot] = slot_added_[last];
+    slots_[slot_ids_[slot]] = slot;
+  }
+  if (!cold_.empty()) {
+    auto src = moves.find(last);
+    auto from = src != moves.end()? src->second : last;
+    if (src != moves.end()) moves.erase(src);
+    if (slot != last) moves[slot] = from;
+    else moves.erase(slot);
+  }
+  slot_ids_.pop_back();
+  slot_added_.pop_back();
+  slots_.erase(it);
+  ++layout_version_;
+}
+
+// Moving cold values one removal at a time would reopen and re-encode two
+// blocks per removal. Values only ever move down from the end, so all
+// sources lie past the new end of the column and the moves of a batch can
+// be applied at once, in slot order, opening every block once.
+void Table::compactCold_(const ColdMoves_& moves) {
+  if (cold_.empty()) return;
+  std::vector<std::pair<uint64_t, uint64_t>> sorted(moves.begin(), moves.end());
+  std::ranges::sort(sorted);
+  std::vector<char> val;
+  for (auto& column: cold_) {
+    val.resize(column.width());
+    for (auto [to, from]: sorted) {
+      column.get(from, val.data());
+      column.set(to, val.data());
+    }
+    column.resize(slot_ids_.size());
   }
 }
@@ -3,31 +3,173 @@
 
 #include <libcosy/actor_type.hpp>
 #include <libcosy/basic_types.hpp>
+#include <libcosy/cold_column.hpp>
+#include <libcosy/field_view.hpp>
+#include <libcosy/primitive_type.hpp>
+#include <libcosy/storage.hpp>
 
 #include <limits>
+#include <memory>
+#include <span>
+#include <unordered_map>
 
 class Table {
 public:
 
   Table(ActorType* type):
+    Table(type, std::make_shared<ActorSet>(
+      ActorSet{std::make_pair(1, std::numeric_limits<ActorId>::max())})) {}
+
+  // Tables sharing an id pool hand out disjoint ids, so actors can be moved
+  // between them without being renumbered.
+  Table(
+    ActorType*                        type,
+    std::shared_ptr<ActorSet>         id_pool,
+    std::shared_ptr<StorageAllocator> allocator = defaultAllocator()
+  ):
     type_(type),
-    available_ids_({std::make_pair(1, std::numeric_limits<ActorId>::max())}) {}
+    available_ids_(std::move(id_pool)),
+    buffer_(allocator),
+    current_(allocator),
+    next_(allocator),
+    cold_(type->numColdAttributes(), ColdColumn(0)) {
+    for (const auto& attr: type->attributes())
+      if (attr.cold) cold_[attr.offset] = ColdColumn(attr.type->size());
+    initColumns_(allocator);
+    zeroed_ = allocator->zeroed();
+  }
+
+  static constexpr size_t column_alignment = 64;
 
   auto newActor() ->ActorId;
   auto newActors(int) ->ActorSet;
   void deleteActor(ActorId);
   void deleteActors(const ActorSet&);
 
-  auto numActors() ->uint64_t;
+  // Add or remove records for ids owned by another table sharing the id
+  // pool. The pool itself is left untouched.
+  void insertActors(const ActorSet&);
+  void extractActors(const ActorSet&);
+
+  auto numActors() const ->uint64_t;
+  auto contains(ActorId) const ->bool;
+
+  // Changes whenever actors are added, removed or moved to another slot,
+  // so that the slot of an actor cached at one version is valid as long
+  // as the version stays the same.
+  auto layoutVersion() const ->uint64_t;
+
+  // For each slot, the layout version right after its actor was added.
+  // Every added actor gets a version of its own, which tells apart actors
+  // reusing an id.
+  auto addedVersions() const ->std::span<const uint64_t>;
+
+  auto type() const ->ActorType*;
+  auto slot(ActorId) const ->uint64_t;
+  auto actorAt(uint64_t slot) const ->ActorId;
+  auto record(ActorId) ->char*;
+  auto data() ->char*;
+
+  // Views of a single attribute. Double-buffered attributes are read
+  // through current() and written through next(); swapBuffers() makes the
+  // next state current at the end of a tick without copying. Afterwards
+  // next() holds the state of two ticks ago, so every actor has to be
+  // written each tick or it reverts to that older value.
+  auto field(const Attribute&) ->FieldView;
+  auto current(const Attribute&) const ->ConstFieldView;
+  auto next(const Attribute&) ->FieldView;
+  void swapBuffers();
+
+  auto cold(const Attribute&) ->ColdColumn&;
+
+  // The column of a column attribute, as lanes of T. T must have the size
+  // of the elements of a primitive attribute type, or the size of any
+  // other type, which is stored as a single lane.
+  template<class T>
+  auto column(const Attribute& attr) ->ColumnView<T> {
+    auto raw = column_(attr, sizeof(T));
+    return ColumnView<T>{
+      .data        = reinterpret_cast<T*>(raw.data),
+      .size        = raw.size,
+      .padded_size = raw.padded_size,
+      .lane_stride = raw.lane_stride,
+      .lanes       = raw.lanes,
+    };
+  }
+
+  // The value of a column attribute in one slot, with its lanes
+  // interleaved as in a record.
+  void getColumnValue(const Attribute&, uint64_t slot, char* out) const;
+  void setColumnValue(const Attribute&, uint64_t slot, const char* in);
+
+  // The double-buffered part of the current state of a record.
+  auto bufferedRecord(ActorId) ->char*;
+
+  // Binds the records in slots [first, first + count) to a NUMA node, so a
+  // worker thread can place the chunk of the table it processes locally.
+  // Placements stick to the slots: they are applied again whenever the
+  // table reallocates its storage. With allocators handing out zeroed
+  // memory, spawning actors leaves their records untouched, so that the
+  // first thread to write a chunk is the one its pages are local to.
+  void placeSlots(uint64_t first, uint64_t count, int node);
+
+  // Permutes the records so that the record in slot order[i] moves to slot
+  // i. Actor ids are unchanged. The copy is split over threads, into new
+  // storage bound as placeSlots asked for.
+  void reorder(const std::vector<uint64_t>& order, unsigned threads = 0);
+
+  // Serializes the complete state of the table, including its slot order
+  // and the id pool, and restores it into an empty table of the same type.
+  // Restoring replaces the contents of the id pool.
+  void saveState(std::vector<char>& buf) const;
+  void loadState(std::span<const char> buf);
 
 private:
 
+  struct ColumnLayout_ {
+    size_t element_size;
+    int    lanes;
+  };
+
+  struct Placement_ {
+    uint64_t first,
+             count;
+    int      node;
+  };
+
+  void place_(const Storage&, size_t size, uint64_t lane_stride, int lanes, const Placement_&) const;
+  void placeAll_(const Placement_&) const;
+
+  void initColumns_(const std::shared_ptr<StorageAllocator>& allocator);
+  auto column_(const Attribute&, size_t element_size) ->ColumnView<char>;
+  auto columnStride_() const ->uint64_t;
+  void resizeColumns_(uint64_t old_stride);
+
   void resizeBuffer_();
+  void appendSlot_(ActorId);
+  // Destination slot of a cold value to the slot it comes from.
+  using ColdMoves_ = std::unordered_map<uint64_t, uint64_t>;
+
+  void removeSlot_(ActorId, ColdMoves_&);
+  void compactCold_(const ColdMoves_&);
 
-  ActorType*        type_;
-  ActorSet          available_ids_;
-  std::vector<char> buffer_;
-  uint64_t          num_actors_ = 0;
+  ActorType*                             type_;
+  std::shared_ptr<ActorSet>              available_ids_;
+  Storage                                buffer_;
+  Storage                                current_;
+  Storage                                next_;
+  std::vector<ColdColumn>                cold_;
+  std::vector<Storage>                   columns_;
+  std::vector<ColumnLayout_>             column_layouts_;
+  uint64_t                               capacity_ = 0;
+  std::vector<ActorId>                   slot_ids_;
+  std::vector<uint64_t>                  slot_added_;
+  std::unordered_map<ActorId, uint64_t>  slots_;
+  uint64_t                               num_actors_ = 0;
+  uint64_t                               layout_version_ = 0;
+  std::vector<Placement_>                placements_;
+  bool                                   zeroed_ = false;
+  uint64_t                               touched_ = 0; // slots written since allocation
 };
 
 #endif // table_hpp_INCLUDED
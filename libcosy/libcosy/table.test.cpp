@@ -0,0 +1,301 @@
+#include <libcosy/mock/attribute_type.hpp>
+#include <libcosy/primitive_type.hpp>
+#include <libcosy/table.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+TEST_CASE("Table::newActors", "[Table]") {
+  AttributeTypeMock atm {"type mock", 4, 4};
+  ActorType type("actor", RecordType{Attribute{.name = "attr", .type = &atm}});
+  Table table(&type);
+
+  REQUIRE(table.newActor() == 1);
+  REQUIRE(table.newActors(3) == ActorSet{{2, 4}});
+  REQUIRE(table.numActors() == 4);
+  REQUIRE(table.slot(1) == 0);
+  REQUIRE(table.slot(4) == 3);
+  REQUIRE(table.actorAt(2) == 3);
+}
+
+TEST_CASE("Table::deleteActors", "[Table]") {
+  AttributeTypeMock atm {"type mock", 4, 4};
+  ActorType type("actor", RecordType{Attribute{.name = "attr", .type = &atm}});
+  Table table(&type);
+  table.newActors(4);
+  for (ActorId id = 1; id <= 4; ++id) std::memcpy(table.record(id), &id, 4);
+
+  table.deleteActors(ActorSet{2});
+  REQUIRE(table.numActors() == 3);
+  REQUIRE(!table.contains(2));
+  REQUIRE(table.slot(4) == 1);
+  for (ActorId id: {1, 3, 4}) {
+    uint32_t val;
+    std::memcpy(&val, table.record(id), 4);
+    REQUIRE(val == id);
+  }
+  REQUIRE(table.newActor() == 2);
+}
+
+TEST_CASE("Table: double-buffered attributes", "[Table]") {
+  AttributeTypeMock atm {"type mock", 4, 4};
+  ActorType type("actor", RecordType{
+    Attribute{.name = "plain", .type = &atm},
+    Attribute{.name = "state", .type = &atm, .double_buffered = true},
+  });
+  REQUIRE(type.size() == 4);
+  REQUIRE(type.bufferedSize() == 4);
+
+  Table table(&type);
+  table.newActors(3);
+  auto& state = *type.attribute("state");
+  REQUIRE_THROWS_AS(table.field(state), std::invalid_argument);
+  REQUIRE_THROWS_AS(table.current(*type.attribute("plain")), std::invalid_argument);
+
+  for (uint64_t slot = 0; slot < 3; ++slot) table.next(state).set<uint32_t>(slot, slot + 1);
+  REQUIRE(table.current(state).get<uint32_t>(0) == 0);
+  table.swapBuffers();
+  for (uint64_t slot = 0; slot < 3; ++slot) {
+    REQUIRE(table.current(state).get<uint32_t>(slot) == slot + 1);
+    table.next(state).set<uint32_t>(slot, table.current(state).get<uint32_t>(slot) * 2);
+  }
+  table.swapBuffers();
+  REQUIRE(table.current(state).get<uint32_t>(2) == 6);
+
+  table.deleteActor(1);
+  REQUIRE(table.current(state).get<uint32_t>(table.slot(3)) == 6);
+}
+
+TEST_CASE("Table: cold attributes", "[Table]") {
+  AttributeTypeMock atm {"type mock", 4, 4};
+  ActorType type("actor", RecordType{
+    Attribute{.name = "hot",  .type = &atm},
+    Attribute{.name = "cold", .type = &atm, .cold = true},
+  });
+  REQUIRE(type.size() == 4);
+  REQUIRE(type.numColdAttributes() == 1);
+
+  Table table(&type);
+  table.newActors(3);
+  auto& cold = table.cold(*type.attribute("cold"));
+  for (uint32_t slot = 0; slot < 3; ++slot) cold.set(slot, reinterpret_cast<const char*>(&slot));
+
+  table.deleteActor(1);
+  uint32_t val;
+  cold.get(table.slot(3), reinterpret_cast<char*>(&val));
+  REQUIRE(val == 2);
+  REQUIRE(cold.size() == 2);
+
+  // Batches of removals spanning several blocks.
+  auto ids = table.newActors(1000);
+  for (uint32_t slot = 0; slot < table.numActors(); ++slot) {
+    uint32_t id = table.actorAt(slot);
+    cold.set(slot, reinterpret_cast<const char*>(&id));
+  }
+  ActorSet removed;
+  ids.forEach([&](ActorId id) { if (id % 3 == 0 || id > 900) removed.insert(id); });
+  table.deleteActors(removed);
+  table.extractActors(ActorSet{4, 5, 7, 8, 500, 502, 503});
+  REQUIRE(cold.size() == table.numActors());
+  for (uint32_t slot = 0; slot < table.numActors(); ++slot) {
+    cold.get(slot, reinterpret_cast<char*>(&val));
+    REQUIRE(val == table.actorAt(slot));
+  }
+}
+
+TEST_CASE("Table::reorder", "[Table]") {
+  AttributeTypeMock atm {"type mock", 4, 4};
+  ActorType type("actor", RecordType{
+    Attribute{.name = "hot",  .type = &atm},
+    Attribute{.name = "cur",  .type = &atm, .double_buffered = true},
+    Attribute{.name = "cold", .type = &atm, .cold = true},
+  });
+  auto& hot  = *type.attribute("hot");
+  auto& cur  = *type.attribute("cur");
+  auto& cold = *type.attribute("cold");
+
+  Table table(&type);
+  table.newActors(4);
+  for (uint32_t slot = 0; slot < 4; ++slot) {
+    table.field(hot).set(slot, slot * 10);
+    table.next(cur).set(slot, slot * 100);
+    table.cold(cold).set(slot, reinterpret_cast<const char*>(&slot));
+  }
+  table.swapBuffers();
+
+  table.reorder({3, 1, 0, 2});
+  REQUIRE(table.slot(4) == 0);
+  REQUIRE(table.slot(1) == 2);
+  REQUIRE(table.actorAt(3) == 3);
+  REQUIRE(table.field(hot).get<uint32_t>(0) == 30);
+  REQUIRE(table.current(cur).get<uint32_t>(3) == 200);
+  uint32_t val;
+  table.cold(cold).get(1, reinterpret_cast<char*>(&val));
+  REQUIRE(val == 1);
+
+  REQUIRE_THROWS_AS(table.reorder({0, 1, 1, 2}), std::invalid_argument);
+  REQUIRE_THROWS_AS(table.reorder({0, 1}), std::invalid_argument);
+}
+
+namespace {
+  // Hands out zeroed memory and records the placements made.
+  class PlacingAllocator_: public StorageAllocator {
+  public:
+
+    struct Place {
+      char*  ptr;
+      size_t size;
+      int    node;
+    };
+
+    auto allocate(size_t size) ->void* override {
+      auto ptr = HeapAllocator().allocate(size);
+      std::memset(ptr, 0, size);
+      return ptr;
+    }
+
+    void deallocate(void* ptr, size_t size) override {
+      HeapAllocator().deallocate(ptr, size);
+    }
+
+    void place(void* ptr, size_t size, int node) override {
+      places.push_back({static_cast<char*>(ptr), size, node});
+    }
+
+    auto zeroed() const ->bool override { return true; }
+
+    std::vector<Place> places;
+  };
+}
+
+TEST_CASE("MmapAllocator: NUMA nodes", "[Table]") {
+  REQUIRE_THROWS_AS(MmapAllocator(HugePages::none, NumaPolicy::node, -1), std::invalid_argument);
+  MmapAllocator allocator(HugePages::none);
+  auto ptr = allocator.allocate(4096);
+  REQUIRE_THROWS_AS(allocator.place(ptr, 4096, 64), std::invalid_argument);
+  REQUIRE_THROWS_AS(allocator.place(ptr, 4096, numNumaNodes()), std::invalid_argument);
+  allocator.deallocate(ptr, 4096);
+}
+
+TEST_CASE("Table::placeSlots", "[Table]") {
+  AttributeTypeMock atm {"type mock", 4, 4};
+  ActorType type("actor", RecordType{Attribute{.name = "attr", .type = &atm}});
+  auto& attr = *type.attribute("attr");
+  auto allocator = std::make_shared<PlacingAllocator_>();
+  Table table(&type, std::make_shared<ActorSet>(ActorSet{{1, 1000}}), allocator);
+  table.newActors(4);
+  table.placeSlots(2, 2, 1);
+  REQUIRE(allocator->places.size() == 1);
+
+  // Placements follow the slots into reallocated storage.
+  table.newActors(100);
+  REQUIRE(allocator->places.size() == 2);
+  REQUIRE(allocator->places.back().ptr == table.data() + 2 * 4);
+  REQUIRE(allocator->places.back().size == 2 * 4);
+  REQUIRE(allocator->places.back().node == 1);
+  table.reorder([] { std::vector<uint64_t> order(104); for (uint64_t i = 0; i < 104; ++i) order[i] = 103 - i; return order; }());
+  REQUIRE(allocator->places.back().ptr == table.data() + 2 * 4);
+
+  // Reused slots are cleared even though fresh ones are not.
+  table.field(attr).set<uint32_t>(table.slot(104), 7);
+  table.deleteActor(104);
+  auto id = table.newActor();
+  REQUIRE(table.field(attr).get<uint32_t>(table.slot(id)) == 0);
+}
+
+TEST_CASE("Table::saveState", "[Table]") {
+  AttributeTypeMock atm {"type mock", 4, 4};
+  ActorType type("actor", RecordType{
+    Attribute{.name = "hot",  .type = &atm},
+    Attribute{.name = "cur",  .type = &atm, .double_buffered = true},
+    Attribute{.name = "cold", .type = &atm, .cold = true},
+  });
+  auto& hot  = *type.attribute("hot");
+  auto& cur  = *type.attribute("cur");
+  auto& cold = *type.attribute("cold");
+
+  Table table(&type);
+  table.newActors(5);
+  table.deleteActor(2);
+  for (uint32_t slot = 0; slot < 4; ++slot) {
+    table.field(hot).set(slot, slot * 10);
+    table.next(cur).set(slot, slot * 100);
+    table.cold(cold).set(slot, reinterpret_cast<const char*>(&slot));
+  }
+  std::vector<char> state;
+  table.saveState(state);
+
+  Table restored(&type);
+  restored.loadState(state);
+  REQUIRE(restored.numActors() == 4);
+  for (uint64_t slot = 0; slot < 4; ++slot) {
+    REQUIRE(restored.actorAt(slot) == table.actorAt(slot));
+    REQUIRE(restored.field(hot).get<uint32_t>(slot) == slot * 10);
+    REQUIRE(restored.next(cur).get<uint32_t>(slot) == slot * 100);
+    uint32_t val;
+    restored.cold(cold).get(slot, reinterpret_cast<char*>(&val));
+    REQUIRE(val == slot);
+  }
+  REQUIRE(restored.newActor() == 2);
+  REQUIRE_THROWS_AS(restored.loadState(state), std::logic_error);
+
+  Table truncated(&type);
+  REQUIRE_THROWS_AS(truncated.loadState(std::span(state.data(), state.size() - 1)), std::invalid_argument);
+  REQUIRE(truncated.numActors() == 0);
+  truncated.loadState(state);
+  REQUIRE(truncated.numActors() == 4);
+}
+
+TEST_CASE("Table: column attributes", "[Table]") {
+  auto& types = TypeRegistry::global();
+  ActorType type("actor", RecordType{
+    Attribute{.name = "hot", .type = types.get("u32")},
+    Attribute{.name = "pos", .type = types.get("vec3"), .column = true},
+    Attribute{.name = "hist", .type = types.get("u16[5]"), .column = true},
+  });
+  REQUIRE(type.size() == 4);
+  REQUIRE(type.numColumnAttributes() == 2);
+  auto& pos  = *type.attribute("pos");
+  auto& hist = *type.attribute("hist");
+
+  Table table(&type);
+  table.newActors(100);
+  REQUIRE_THROWS_AS(table.field(pos), std::invalid_argument);
+  REQUIRE_THROWS_AS(table.column<double>(pos), std::invalid_argument);
+
+  auto col = table.column<float>(pos);
+  REQUIRE(col.lanes == 3);
+  REQUIRE(col.size == 100);
+  REQUIRE(col.padded_size == 112);
+  for (int k = 0; k < 3; ++k) {
+    REQUIRE(reinterpret_cast<uintptr_t>(col.lane(k)) % Table::column_alignment == 0);
+    for (uint64_t slot = 0; slot < col.padded_size; ++slot) col.lane(k)[slot] = slot * 10 + k;
+  }
+  REQUIRE(table.column<uint16_t>(hist).padded_size == 128);
+
+  float val[3];
+  table.getColumnValue(pos, table.slot(50), reinterpret_cast<char*>(val));
+  REQUIRE((val[0] == 490 && val[1] == 491 && val[2] == 492));
+
+  table.deleteActor(3);
+  table.newActors(200);
+  col = table.column<float>(pos);
+  REQUIRE(col.size == 299);
+  REQUIRE(col.lane(1)[table.slot(100)] == 991);
+  REQUIRE(col.lane(2)[table.slot(2)] == 12);
+  REQUIRE(col.lane(0)[table.slot(299)] == 0);
+  for (uint64_t slot = col.size; slot < col.padded_size; ++slot) REQUIRE(col.lane(0)[slot] == 0);
+
+  float in[3] = {1, 2, 3};
+  table.setColumnValue(pos, 7, reinterpret_cast<const char*>(in));
+  REQUIRE(col.lane(2)[7] == 3);
+
+  std::vector<char> state;
+  table.saveState(state);
+  Table restored(&type);
+  restored.loadState(state);
+  REQUIRE(restored.column<float>(pos).lane(2)[7] == 3);
+  REQUIRE(restored.column<float>(pos).lane(1)[restored.slot(100)] == 991);
+}
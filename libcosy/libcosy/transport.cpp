@@ -0,0 +1,199 @@
+#include <libcosy/transport.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+struct LocalTransport::Hub_ {
+  std::mutex                                      mutex;
+  std::condition_variable                         cond;
+  std::vector<std::vector<std::optional<Buffer>>> mailboxes; // [to][from]
+};
+
+LocalTransport::LocalTransport(std::shared_ptr<Hub_> hub, int rank):
+  hub_(std::move(hub)),
+  rank_(rank) {}
+
+auto LocalTransport::create(int n) ->std::vector<std::unique_ptr<LocalTransport>> {
+  auto hub = std::make_shared<Hub_>();
+  hub->mailboxes.assign(n, std::vector<std::optional<Buffer>>(n));
+  std::vector<std::unique_ptr<LocalTransport>> transports;
+  for (int rank = 0; rank < n; ++rank)
+    transports.push_back(std::unique_ptr<LocalTransport>(new LocalTransport(hub, rank)));
+  return transports;
+}
+
+auto LocalTransport::rank() const ->int {
+  return rank_;
+}
+
+auto LocalTransport::size() const ->int {
+  return hub_->mailboxes.size();
+}
+
+auto LocalTransport::exchange(std::vector<Buffer> out) ->std::vector<Buffer> {
+  std::vector<Buffer> in(size());
+  in[rank_] = std::move(out[rank_]);
+  std::unique_lock lock(hub_->mutex);
+  for (int peer = 0; peer < size(); ++peer) {
+    if (peer == rank_) continue;
+    // A peer still holding the previous round's buffer is behind by a round.
+    auto& mailbox = hub_->mailboxes[peer][rank_];
+    hub_->cond.wait(lock, [&mailbox] { return !mailbox.has_value(); });
+    mailbox = std::move(out[peer]);
+  }
+  hub_->cond.notify_all();
+  for (int peer = 0; peer < size(); ++peer) {
+    if (peer == rank_) continue;
+    auto& mailbox = hub_->mailboxes[rank_][peer];
+    hub_->cond.wait(lock, [&mailbox] { return mailbox.has_value(); });
+    in[peer] = std::move(*mailbox);
+    mailbox.reset();
+  }
+  hub_->cond.notify_all();
+  return in;
+}
+
+UnixSocketTransport::UnixSocketTransport(int rank, std::vector<int> sockets, std::vector<int> children):
+  rank_(rank),
+  sockets_(std::move(sockets)),
+  children_(std::move(children)) {}
+
+auto UnixSocketTransport::fork(int n) ->std::unique_ptr<UnixSocketTransport> {
+  if (n < 1) throw std::invalid_argument("transport needs at least one rank");
+  std::vector<std::vector<int>> sockets(n, std::vector<int>(n, -1));
+  for (int a = 0; a < n; ++a) {
+    for (int b = a + 1; b < n; ++b) {
+      int pair[2];
+      if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0)
+        throw std::system_error(errno, std::generic_category(), "socketpair");
+      sockets[a][b] = pair[0];
+      sockets[b][a] = pair[1];
+    }
+  }
+
+  int rank = 0;
+  std::vector<int> children;
+  for (int r = 1; r < n; ++r) {
+    auto pid = ::fork();
+    if (pid < 0) throw std::system_error(errno, std::generic_category(), "fork");
+    if (pid == 0) {
+      rank = r;
+      children.clear();
+      break;
+    }
+    children.push_back(pid);
+  }
+
+  for (int a = 0; a < n; ++a) {
+    if (a == rank) continue;
+    for (auto fd: sockets[a]) if (fd >= 0) close(fd);
+  }
+  for (auto fd: sockets[rank]) if (fd >= 0) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  return std::unique_ptr<UnixSocketTransport>(
+    new UnixSocketTransport(rank, std::move(sockets[rank]), std::move(children)));
+}
+
+UnixSocketTransport::~UnixSocketTransport() {
+  for (auto fd: sockets_) if (fd >= 0) close(fd);
+  for (auto pid: children_) waitpid(pid, nullptr, 0);
+}
+
+auto UnixSocketTransport::wait() ->std::vector<int> {
+  std::vector<int> codes;
+  for (auto pid: children_) {
+    int status;
+    if (waitpid(pid, &status, 0) < 0) throw std::system_error(errno, std::generic_category(), "waitpid");
+    codes.push_back(WIFEXITED(status)? WEXITSTATUS(status) : -1);
+  }
+  children_.clear();
+  return codes;
+}
+
+auto UnixSocketTransport::rank() const ->int {
+  return rank_;
+}
+
+auto UnixSocketTransport::size() const ->int {
+  return sockets_.size();
+}
+
+// Buffers are framed by their length, and written and read interleaved so
+// that two ranks sending large buffers to each other cannot deadlock.
+auto UnixSocketTransport::exchange(std::vector<Buffer> out) ->std::vector<Buffer> {
+  struct Peer_ {
+    uint64_t out_size;
+    size_t   written = 0;
+    uint64_t in_size = 0;
+    size_t   read    = 0;
+  };
+
+  auto n = size();
+  std::vector<Buffer> in(n);
+  in[rank_] = std::move(out[rank_]);
+  std::vector<Peer_> peers(n);
+  for (int peer = 0; peer < n; ++peer) peers[peer].out_size = out[peer].size();
+
+  constexpr size_t header = sizeof(uint64_t);
+  auto pending = 2 * (n - 1);
+  std::vector<pollfd> fds;
+  while (pending > 0) {
+    fds.clear();
+    for (int peer = 0; peer < n; ++peer) {
+      if (peer == rank_) continue;
+      auto& p = peers[peer];
+      short events = 0;
+      if (p.written < header + p.out_size) events |= POLLOUT;
+      if (p.read < header || p.read < header + p.in_size) events |= POLLIN;
+      if (events != 0) fds.push_back({.fd = sockets_[peer], .events = events, .revents = 0});
+    }
+    if (poll(fds.data(), fds.size(), -1) < 0) {
+      if (errno == EINTR) continue;
+      throw std::system_error(errno, std::generic_category(), "poll");
+    }
+    for (int peer = 0; peer < n; ++peer) {
+      if (peer == rank_) continue;
+      auto& p  = peers[peer];
+      auto  fd = sockets_[peer];
+
+      if (p.written < header + p.out_size) {
+        ssize_t res;
+        if (p.written < header)
+          res = write(fd, reinterpret_cast<const char*>(&p.out_size) + p.written, header - p.written);
+        else
+          res = write(fd, out[peer].data() + (p.written - header), header + p.out_size - p.written);
+        if (res < 0 && errno != EAGAIN && errno != EINTR)
+          throw std::system_error(errno, std::generic_category(), "write");
+        if (res > 0) p.written += res;
+        if (p.written == header + p.out_size) --pending;
+      }
+
+      if (p.read < header || p.read < header + p.in_size) {
+        ssize_t res;
+        if (p.read < header)
+          res = ::read(fd, reinterpret_cast<char*>(&p.in_size) + p.read, header - p.read);
+        else
+          res = ::read(fd, in[peer].data() + (p.read - header), header + p.in_size - p.read);
+        if (res == 0) throw std::runtime_error("transport: peer closed connection");
+        if (res < 0 && errno != EAGAIN && errno != EINTR)
+          throw std::system_error(errno, std::generic_category(), "read");
+        if (res > 0) {
+          p.read += res;
+          if (p.read == header) in[peer].resize(p.in_size);
+          if (p.read == header + p.in_size) --pending;
+        }
+      }
+    }
+  }
+  return in;
+}
@@ -0,0 +1,73 @@
+#ifndef transport_hpp_INCLUDED
+#define transport_hpp_INCLUDED
+
+#include <memory>
+#include <vector>
+
+// Connects the shards of a simulation. Ranks run in lock step: exchange()
+// is collective, and every rank has to call it the same number of times.
+class Transport {
+public:
+
+  using Buffer = std::vector<char>;
+
+  virtual ~Transport() = default;
+
+  virtual auto rank() const ->int = 0;
+  virtual auto size() const ->int = 0;
+
+  // Sends out[peer] to every peer, and returns the buffers every peer sent
+  // to this rank. The buffer to this rank itself is passed through.
+  virtual auto exchange(std::vector<Buffer> out) ->std::vector<Buffer> = 0;
+};
+
+// Transport between threads of one process.
+class LocalTransport: public Transport {
+public:
+
+  static auto create(int n) ->std::vector<std::unique_ptr<LocalTransport>>;
+
+  auto rank() const ->int override;
+  auto size() const ->int override;
+  auto exchange(std::vector<Buffer> out) ->std::vector<Buffer> override;
+
+private:
+
+  struct Hub_;
+
+  LocalTransport(std::shared_ptr<Hub_> hub, int rank);
+
+  std::shared_ptr<Hub_> hub_;
+  int                   rank_;
+};
+
+// Transport between processes on one host over Unix domain sockets.
+class UnixSocketTransport: public Transport {
+public:
+
+  // Forks n - 1 child processes, all connected to each other, and returns
+  // the transport of the calling process. The parent gets rank 0 and waits
+  // for the children when its transport is destroyed; the children should
+  // exit once done rather than return.
+  static auto fork(int n) ->std::unique_ptr<UnixSocketTransport>;
+
+  ~UnixSocketTransport();
+
+  // Waits for the children and returns their exit codes, in rank order, or
+  // -1 for a child that did not exit normally. Empty on the children.
+  auto wait() ->std::vector<int>;
+
+  auto rank() const ->int override;
+  auto size() const ->int override;
+  auto exchange(std::vector<Buffer> out) ->std::vector<Buffer> override;
+
+private:
+
+  UnixSocketTransport(int rank, std::vector<int> sockets, std::vector<int> children);
+
+  int              rank_;
+  std::vector<int> sockets_; // per peer, -1 for this rank
+  std::vector<int> children_;
+};
+
+#endif // transport_hpp_INCLUDED